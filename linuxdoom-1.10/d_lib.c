@@ -0,0 +1,169 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	The game as a library, see d_lib.h.
+//	D_DoomMain and its loop are left out,
+//	the caller drives G_Ticker directly.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "z_zone.h"
+#include "w_wad.h"
+#include "m_argv.h"
+#include "i_system.h"
+#include "i_sound.h"
+#include "s_sound.h"
+#include "v_video.h"
+
+#include "g_game.h"
+#include "d_main.h"
+#include "r_local.h"
+#include "st_stuff.h"
+#include "wi_stuff.h"
+#include "f_finale.h"
+#include "am_map.h"
+
+#ifdef __GNUG__
+#pragma implementation "d_lib.h"
+#endif
+#include "d_lib.h"
+
+
+extern boolean		setsizeneeded;
+void R_ExecuteSetViewSize (void);
+
+
+
+//
+// D_LibInit
+//
+void D_LibInit (char* wad, int argc, char** argv)
+{
+    int		i;
+	
+    // the parameters as D_DoomMain would have them
+    myargv = malloc ((argc+4)*sizeof(*myargv));
+    if (!myargv)
+	I_Error ("D_LibInit: couldn't allocate parameters");
+    
+    myargc = 0;
+    myargv[myargc++] = "doom";
+    for (i=0 ; i<argc ; i++)
+	myargv[myargc++] = argv[i];
+    if (wad)
+    {
+	myargv[myargc++] = "-iwad";
+	myargv[myargc++] = wad;
+    }
+    myargv[myargc] = NULL;
+
+    D_DoomInit ();
+
+    if (netgame)
+	I_Error ("D_LibInit: netgames are not supported");
+    
+    D_LibReset (startepisode, startmap);
+}
+
+
+
+//
+// D_LibStep
+//
+void D_LibStep (ticcmd_t* cmds, int ntics)
+{
+    int		buf;
+    int		i;
+	
+    for ( ; ntics > 0 ; ntics--, cmds += MAXPLAYERS)
+    {
+	buf = (gametic/ticdup)%BACKUPTICS;
+	for (i=0 ; i<MAXPLAYERS ; i++)
+	    netcmds[i][buf] = cmds[i];
+
+	G_Ticker ();
+	gametic++;
+    }
+
+    S_UpdateSounds (players[consoleplayer].mo);
+}
+
+
+
+//
+// D_LibObserve
+// The drawing part of D_Display,
+// without the wipes and the menu.
+//
+void D_LibObserve (doomobs_t* obs)
+{
+    if (setsizeneeded)
+	R_ExecuteSetViewSize ();
+
+    switch (gamestate)
+    {
+      case GS_LEVEL:
+	if (!gametic)
+	    break;
+	if (automapactive)
+	    AM_Drawer ();
+	else
+	    R_RenderPlayerView (&players[displayplayer]);
+	ST_Drawer (viewheight == SCREENHEIGHT, true);
+	break;
+
+      case GS_INTERMISSION:
+	WI_Drawer ();
+	break;
+
+      case GS_FINALE:
+	F_Drawer ();
+	break;
+
+      case GS_DEMOSCREEN:
+	D_PageDrawer ();
+	break;
+    }
+
+    I_UpdateSound ();
+    obs->audioframes = I_GetMixBuffer (&obs->audio);
+    
+    obs->screen = screens[0];
+    obs->palette = W_CacheLumpName ("PLAYPAL", PU_CACHE);
+    if (st_palette > 0)
+	obs->palette += st_palette*768;
+    obs->player = &players[consoleplayer];
+    obs->gametic = gametic;
+    obs->gamestate = gamestate;
+}
+
+
+
+//
+// D_LibReset
+//
+void D_LibReset (int episode, int map)
+{
+    G_InitNew (startskill, episode, map);
+}
@@ -0,0 +1,77 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	The game as a library. The caller steps it one
+//	tic at a time and looks at the result, nothing
+//	is displayed.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __D_LIB__
+#define __D_LIB__
+
+#include "doomdef.h"
+#include "d_ticcmd.h"
+#include "d_player.h"
+
+#ifdef __GNUG__
+#pragma interface
+#endif
+
+
+//
+// What D_LibObserve gives back.
+// All of it belongs to the game and
+// is good until the next D_LibStep.
+//
+typedef struct
+{
+    byte*		screen;		// SCREENWIDTH*SCREENHEIGHT indexes
+    byte*		palette;	// 256 RGB triples
+    player_t*		player;		// the console player
+    signed short*	audio;		// interleaved stereo, 11025 Hz
+    int			audioframes;
+    int			gametic;
+    gamestate_t		gamestate;
+    
+} doomobs_t;
+
+
+// Starts up with wad as the IWAD, args as more
+// command line parameters, and loads the map
+// -warp or -episode ask for.
+void D_LibInit (char* wad, int argc, char** argv);
+
+// Plays ntics tics. cmds holds MAXPLAYERS
+// ticcmds per tic, one for each player slot.
+void D_LibStep (ticcmd_t* cmds, int ntics);
+
+// Draws the display player's view and mixes
+// the next sound samples.
+void D_LibObserve (doomobs_t* obs);
+
+// Starts a map over, at the start skill.
+void D_LibReset (int episode, int map);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -34,6 +34,7 @@ static const char rcsid[] = "$Id: d_main.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #ifdef NORMALUNIX
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -57,12 +58,15 @@ static const char rcsid[] = "$Id: d_main.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #include "f_wipe.h"
 
 #include "m_argv.h"
+#include "m_bench.h"
 #include "m_misc.h"
+#include "m_swap.h"
 #include "m_menu.h"
 
 #include "i_system.h"
 #include "i_sound.h"
 #include "i_video.h"
+#include "i_thread.h"
 
 #include "g_game.h"
 
@@ -72,6 +76,7 @@ static const char rcsid[] = "$Id: d_main.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #include "am_map.h"
 
 #include "p_setup.h"
+#include "p_tick.h"
 #include "r_local.h"
 
 
@@ -319,7 +324,9 @@ void D_Display (void)
     // normal update
     if (!wipe)
     {
+	M_BenchLap (bp_other);
 	I_FinishUpdate ();              // page flip or blit buffer
+	M_BenchLap (bp_blit);
 	return;
     }
     
@@ -368,6 +375,11 @@ void D_DoomLoop (void)
 
     while (1)
     {
+	M_BenchStartFrame ();
+	
+	// demo seeks move gametic, so not inside TryRunTics
+	G_DoSeekDemo ();
+	
 	// frame syncronous IO operations
 	I_StartFrame ();                
 	
@@ -388,11 +400,14 @@ void D_DoomLoop (void)
 	{
 	    TryRunTics (); // will run at least one tic
 	}
+	M_BenchLap (bp_playsim);
 		
 	S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
+	M_BenchLap (bp_sound);
 
 	// Update display, next frame, with current state.
 	D_Display ();
+	M_BenchLap (bp_other);
 
 #ifndef SNDSERV
 	// Sound mixing for the buffer is snychronous.
@@ -403,6 +418,8 @@ void D_DoomLoop (void)
 	// Update sound output.
 	I_SubmitSound();
 #endif
+	M_BenchLap (bp_sound);
+	M_BenchEndFrame ();
     }
 }
 
@@ -554,6 +571,53 @@ void D_AddFile (char *file)
     wadfiles[numwadfiles] = newfile;
 }
 
+//
+// D_IWADMode
+// Works out the game mode of an -iwad from
+// its map lumps, before W_Init has read it,
+// so -warp and the banner can go by it.
+//
+static GameMode_t D_IWADMode (char* filename)
+{
+    FILE*	f;
+    wadinfo_t	header;
+    filelump_t	lump;
+    int		i;
+    int		n;
+    GameMode_t	mode;
+	
+    mode = indetermined;
+    f = fopen (filename, "rb");
+    if (!f)
+	return mode;
+	
+    if (fread (&header, sizeof(header), 1, f) == 1
+	&& !strncmp (header.identification, "IWAD", 4)
+	&& !fseek (f, LONG(header.infotableofs), SEEK_SET))
+    {
+	n = LONG(header.numlumps);
+	for (i=0 ; i<n && fread (&lump, sizeof(lump), 1, f) == 1 ; i++)
+	{
+	    if (!strncasecmp (lump.name, "MAP01", 8))
+	    {
+		mode = commercial;
+		break;
+	    }
+	    if (!strncasecmp (lump.name, "E4M1", 8))
+		mode = retail;
+	    else if (!strncasecmp (lump.name, "E2M1", 8)
+		     && mode != retail)
+		mode = registered;
+	    else if (!strncasecmp (lump.name, "E1M1", 8)
+		     && mode == indetermined)
+		mode = shareware;
+	}
+    }
+	
+    fclose (f);
+    return mode;
+}
+
 //
 // IdentifyVersion
 // Checks availability of IWAD files by name,
@@ -571,6 +635,7 @@ void IdentifyVersion (void)
     char*	doom2fwad;
     char*	plutoniawad;
     char*	tntwad;
+    int		p;
 
 #ifdef NORMALUNIX
     char *home;
@@ -655,6 +720,15 @@ void IdentifyVersion (void)
 	return;
     }
 
+    // told which, the lumps will show the game mode
+    p = M_CheckParm ("-iwad");
+    if (p && p < myargc-1)
+    {
+	gamemode = D_IWADMode (myargv[p+1]);
+	D_AddFile (myargv[p+1]);
+	return;
+    }
+
     if ( !access (doom2fwad,R_OK) )
     {
 	gamemode = commercial;
@@ -791,9 +865,183 @@ void FindResponseFile (void)
 
 
 //
-// D_DoomMain
+// D_FastDemoLoop
+// Runs game tics back to back with no display, sound or pacing.
+// G_CheckDemoStatus reports and quits when the demo ends.
 //
-void D_DoomMain (void)
+void D_FastDemoLoop (void)
+{
+    while (1)
+    {
+	G_Ticker ();
+	gametic++;
+	maketic++;
+    }
+}
+
+
+//
+// D_VerifyDemos
+// The list has one demo lump or file per line,
+// blank lines and lines starting with # are skipped.
+// Exits with 1 if any demo failed or desynced.
+//
+void D_VerifyDemos (char* listname)
+{
+    byte*		list;
+    char*		text;
+    char*		s;
+    char*		e;
+    char**		names;
+    int			numnames;
+    int			length;
+    demoverify_t*	results;
+    demoverify_t*	r;
+    char		where[9];
+    int			failed;
+    int			truncated;
+    int			desynced;
+    int			unchecked;
+    long long		starttime;
+    int			i;
+    int			j;
+	
+    length = M_ReadFile (listname, &list);
+    text = malloc (length+1);
+    names = malloc ((length/2+1)*sizeof(*names));
+    if (!text || !names)
+	I_Error ("D_VerifyDemos: couldn't allocate for %s", listname);
+    memcpy (text, list, length);
+    text[length] = 0;
+    Z_Free (list);
+
+    numnames = 0;
+    for (s = strtok (text, "\r\n") ; s ; s = strtok (NULL, "\r\n"))
+    {
+	while (*s == ' ' || *s == '\t')
+	    s++;
+	e = s + strlen (s);
+	while (e > s && (e[-1] == ' ' || e[-1] == '\t'))
+	    *--e = 0;
+	if (*s && *s != '#')
+	    names[numnames++] = s;
+    }
+	
+    results = malloc ((numnames+1)*sizeof(*results));
+    if (!results)
+	I_Error ("D_VerifyDemos: couldn't allocate %i results", numnames);
+	
+    printf ("D_VerifyDemos: %i demos, %i at a time.\n",
+	    numnames, I_NumThreads ());
+    starttime = I_GetTimeUS ();
+    G_VerifyDemos (numnames, names, I_NumThreads (), results);
+
+    failed = truncated = desynced = unchecked = 0;
+    for (i=0 ; i<numnames ; i++)
+    {
+	r = &results[i];
+	if (r->failed)
+	{
+	    printf ("%s: FAILED\n", names[i]);
+	    failed++;
+	    continue;
+	}
+	    
+	if (gamemode == commercial)
+	    sprintf (where, "MAP%02i", r->map);
+	else
+	    sprintf (where, "E%iM%i", r->episode, r->map);
+	printf ("%s: %i tics, ended in %s %s, %i exits, %i deaths, "
+		"hash %08x",
+		names[i], r->tics, where,
+		r->gamestate == GS_LEVEL ? "level" :
+		r->gamestate == GS_INTERMISSION ? "intermission" : "finale",
+		r->exits, r->deaths, r->hash);
+	if (r->truncated)
+	{
+	    printf (", truncated");
+	    truncated++;
+	}
+	    
+	if (r->desynctic >= 0)
+	{
+	    printf (", DESYNC at tic %i in", r->desynctic);
+	    for (j=0 ; j<NUMSYNCHASH ; j++)
+		if (r->desyncmask & 1<<j)
+		    printf (" %s", synchashnames[j]);
+	    desynced++;
+	}
+	else if (!r->hashedtics)
+	{
+	    printf (", no .hsh");
+	    unchecked++;
+	}
+	else
+	    printf (", in sync over %i hashed tics",
+		    r->hashedtics < r->tics+1 ? r->hashedtics : r->tics+1);
+	printf ("\n");
+    }
+	
+    printf ("%i demos in %.1f s: %i failed, %i truncated, %i desynced, "
+	    "%i not checked against a .hsh\n",
+	    numnames, (I_GetTimeUS () - starttime)/1000000.0,
+	    failed, truncated, desynced, unchecked);
+	
+    exit (failed || desynced);
+}
+
+
+//
+// D_Rollout
+// -rollout <tics> <stream> ...
+// Plays each stream from the level the
+// game started in, see G_Rollout, and
+// prints what came of it.
+//
+void D_Rollout (int p)
+{
+    int		tics;
+    int		numstreams;
+    int		i;
+    rollout_t*	results;
+	
+    if (netgame)
+	I_Error ("-rollout can't be used in a netgame");
+    
+    if (gameaction == ga_loadgame)
+	G_DoLoadGame ();
+    if (gamestate != GS_LEVEL)
+	I_Error ("-rollout needs a level, use -warp or -loadgame");
+
+    tics = atoi (myargv[p+1]);
+    for (numstreams = 0 ;
+	 p+2+numstreams < myargc && myargv[p+2+numstreams][0] != '-' ;
+	 numstreams++)
+	;
+	
+    results = malloc (numstreams*sizeof(*results));
+    if (!results)
+	I_Error ("D_Rollout: couldn't allocate %i results", numstreams);
+    
+    G_Rollout (numstreams, &myargv[p+2], tics, results);
+
+    for (i=0 ; i<numstreams ; i++)
+	printf ("%s: %i tics, health %i, kills %i, items %i, secrets %i%s\n",
+		myargv[p+2+i], results[i].tics, results[i].health,
+		results[i].killcount, results[i].itemcount,
+		results[i].secretcount,
+		results[i].exited ? ", exited" :
+		results[i].dead ? ", dead" : "");
+
+    exit (0);
+}
+
+
+//
+// D_DoomInit
+// All the startup, up to starting a game.
+//
+void D_DoomInit (void)
 {
     int             p;
     char                    file[256];
@@ -948,7 +1196,7 @@ void D_DoomMain (void)
     p = M_CheckParm ("-playdemo");
 
     if (!p)
-	p = M_CheckParm ("-timedemo");
+	p = M_CheckParm ("-fastdemo");
 
     if (p && p < myargc-1)
     {
@@ -956,6 +1204,18 @@ void D_DoomMain (void)
 	D_AddFile (file);
 	printf("Playing demo %s.lmp.\n",myargv[p+1]);
     }
+
+    // -timedemo takes several demos, played in turn
+    p = M_CheckParm ("-timedemo");
+    if (p)
+    {
+	while (++p != myargc && myargv[p][0] != '-')
+	{
+	    sprintf (file,"%s.lmp", myargv[p]);
+	    D_AddFile (file);
+	    printf("Timing demo %s.lmp.\n",myargv[p]);
+	}
+    }
     
     // get skill / episode / map from parms
     startskill = sk_medium;
@@ -999,7 +1259,7 @@ void D_DoomMain (void)
     {
 	if (gamemode == commercial)
 	    startmap = atoi (myargv[p+1]);
-	else
+	else if (p < myargc-2)
 	{
 	    startepisode = myargv[p+1][0]-'0';
 	    startmap = myargv[p+2][0]-'0';
@@ -1019,6 +1279,16 @@ void D_DoomMain (void)
 
     printf ("W_Init: Init WADfiles.\n");
     W_InitMultipleFiles (wadfiles);
+
+    // lump cache hit/miss counters, reported at exit
+    p = M_CheckParm ("-lumpstats");
+    if (p)
+    {
+	if (p < myargc-1 && myargv[p+1][0] != '-')
+	    W_InitLumpStats (myargv[p+1]);
+	else
+	    W_InitLumpStats ("lumpstats.txt");
+    }
     
 
     // Check for -file in shareware
@@ -1122,7 +1392,26 @@ void D_DoomMain (void)
 	statcopy = (void*)atoi(myargv[p+1]);
 	printf ("External statistics registered.\n");
     }
+}
+
+
+//
+// D_DoomMain
+//
+void D_DoomMain (void)
+{
+    int             p;
+    int             i;
+    char                    file[256];
+
+    D_DoomInit ();
     
+    synchash = M_CheckParm ("-synchash");
+	
+    p = M_CheckParm ("-verifydemos");
+    if (p && p < myargc-1)
+	D_VerifyDemos (myargv[p+1]);	// never returns
+	
     // start the apropriate game based on parms
     p = M_CheckParm ("-record");
 
@@ -1132,6 +1421,25 @@ void D_DoomMain (void)
 	autostart = true;
     }
 	
+    // keyframes for seeking in demos, every 10 seconds by default
+    p = M_CheckParm ("-keyframes");
+    if (p)
+    {
+	keyframetics = 10*TICRATE;
+	if (p < myargc-1 && myargv[p+1][0] != '-')
+	    keyframetics = atoi (myargv[p+1]);
+	if (keyframetics < 1)
+	    keyframetics = 1;
+    }
+	
+    p = M_CheckParm ("-seek");
+    if (p && p < myargc-1)
+    {
+	if (!keyframetics)
+	    keyframetics = 10*TICRATE;
+	G_SeekDemo (atoi (myargv[p+1]));
+    }
+	
     p = M_CheckParm ("-playdemo");
     if (p && p < myargc-1)
     {
@@ -1141,12 +1449,21 @@ void D_DoomMain (void)
     }
 	
     p = M_CheckParm ("-timedemo");
-    if (p && p < myargc-1)
+    if (p && p < myargc-1 && myargv[p+1][0] != '-')
     {
-	G_TimeDemo (myargv[p+1]);
+	for (i=p+1 ; i<myargc && myargv[i][0] != '-' ; i++)
+	    ;
+	G_TimeDemo (&myargv[p+1], i-p-1);
 	D_DoomLoop ();  // never returns
     }
 	
+    p = M_CheckParm ("-fastdemo");
+    if (p && p < myargc-1)
+    {
+	G_FastDemo (myargv[p+1]);
+	D_FastDemoLoop ();  // never returns
+    }
+	
     p = M_CheckParm ("-loadgame");
     if (p && p < myargc-1)
     {
@@ -1167,5 +1484,9 @@ void D_DoomMain (void)
 
     }
 
+    p = M_CheckParm ("-rollout");
+    if (p && p < myargc-2)
+	D_Rollout (p);	// never returns
+
     D_DoomLoop ();  // never returns
 }
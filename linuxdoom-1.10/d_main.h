@@ -48,6 +48,9 @@ void D_AddFile (char *file);
 //
 void D_DoomMain (void);
 
+// The startup part of D_DoomMain, for D_LibInit.
+void D_DoomInit (void);
+
 // Called by IO functions when input is detected.
 void D_PostEvent (event_t* ev);
 
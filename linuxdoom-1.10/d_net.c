@@ -765,3 +765,19 @@ void TryRunTics (void)
 	NetUpdate ();	// check for new console commands
     }
 }
+
+
+
+//
+// D_ShiftTics
+// A demo seek sets gametic to match the tic it lands on.
+// Moving the rest by the same amount keeps TryRunTics
+// from waiting for, or running ahead to, the old count.
+// Only the local node is moved, seeks are single node.
+//
+void D_ShiftTics (int delta)
+{
+    maketic += delta;
+    nettics[0] += delta;
+    resendto[0] += delta;
+}
@@ -138,6 +138,10 @@ void D_QuitNetGame (void);
 //? how many ticks to run?
 void TryRunTics (void);
 
+// Moves maketic and the node counters after gametic
+// was moved by delta, see G_DoSeekDemo.
+void D_ShiftTics (int delta);
+
 
 #endif
 
@@ -66,6 +66,11 @@ typedef struct thinker_s
     struct thinker_s*	prev;
     struct thinker_s*	next;
     think_t		function;
+
+    // The thinkers P_RunThinkers calls, in list order.
+    // Dormant mobjs are left off, with runprev NULL.
+    struct thinker_s*	runprev;
+    struct thinker_s*	runnext;
     
 } thinker_t;
 
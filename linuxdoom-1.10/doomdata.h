@@ -175,7 +175,10 @@ typedef struct
 // BSP node structure.
 
 // Indicate a leaf.
-#define	NF_SUBSECTOR	0x8000
+// The NODES lump flags leaves in 16 bits,
+//  node_t and extended nodes use 32 bits.
+#define	NF_MAPSUBSECTOR	0x8000
+#define	NF_SUBSECTOR	0x80000000
 
 typedef struct
 {
@@ -189,7 +192,7 @@ typedef struct
   // clip against view frustum.
   short		bbox[2][4];
 
-  // If NF_SUBSECTOR its a subsector,
+  // If NF_MAPSUBSECTOR its a subsector,
   // else it's a node of another subtree.
   unsigned short	children[2];
 
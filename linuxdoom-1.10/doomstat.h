@@ -138,6 +138,7 @@ extern  boolean		viewactive;
 
 extern  boolean		nodrawers;
 extern  boolean		noblit;
+extern  boolean		fastdemo;	// -fastdemo, simulation only
 
 extern	int		viewwindowx;
 extern	int		viewwindowy;
@@ -186,6 +187,12 @@ extern  boolean	demorecording;
 // Quit after playing a demo from cmdline.
 extern  boolean		singledemo;	
 
+// Hash the level every tic, see G_SyncHashTic.
+extern  boolean		synchash;
+
+// Snapshot demo playback every so many tics, see G_SeekDemo.
+extern  int		keyframetics;
+
 
 
 
@@ -257,6 +264,9 @@ extern  int             mouseSensitivity;
 // debug flag to cancel adaptiveness
 extern  boolean         singletics;	
 
+#define	BODYQUESIZE	32
+
+extern  mobj_t*         bodyque[BODYQUESIZE];
 extern  int             bodyqueslot;
 
 
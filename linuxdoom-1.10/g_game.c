@@ -33,6 +33,7 @@ rcsid[] = "$Id: g_game.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 #include "z_zone.h"
 #include "f_finale.h"
 #include "m_argv.h"
+#include "m_bench.h"
 #include "m_misc.h"
 #include "m_menu.h"
 #include "m_random.h"
@@ -73,6 +74,7 @@ rcsid[] = "$Id: g_game.c,v 1.8 1997/02/03 22:45:09 b1 Exp $";
 
 #define SAVEGAMESIZE	0x2c000
 #define SAVESTRINGSIZE	24
+#define DEMOMARKER	0x80
 
 
 
@@ -92,6 +94,9 @@ void	G_DoCompleted (void);
 void	G_DoVictory (void); 
 void	G_DoWorldDone (void); 
 void	G_DoSaveGame (void); 
+
+static void	G_EndVerify (void);
+static void	G_SeekDemoStep (int steps);
  
  
 gameaction_t    gameaction; 
@@ -110,6 +115,14 @@ boolean         timingdemo;             // if true, exit with report on completi
 boolean         nodrawers;              // for comparative timing purposes 
 boolean         noblit;                 // for comparative timing purposes 
 int             starttime;          	// for comparative timing purposes  	 
+boolean         fastdemo;               // simulation only, report tics/sec 
+static char**   timedemonames;          // -timedemo plays these in turn 
+static int      numtimedemos;
+static int      timedemonum;
+static int      timedemotic;            // gametic at the start of the demo 
+static demoverify_t* verifyresult;      // -verifydemos child, else NULL 
+static long long fastdemostart;         // I_GetTimeUS at the first demo tic 
+static int      fastdemotic;            // gametic at the first demo tic 
  
 boolean         viewactive; 
  
@@ -132,6 +145,7 @@ byte*		demobuffer;
 byte*		demo_p;
 byte*		demoend; 
 boolean         singledemo;            	// quit after playing a demo from cmdline 
+boolean         synchash;               // -synchash, hash the level every tic 
  
 boolean         precache = true;        // if true, load all graphics at start 
  
@@ -207,7 +221,6 @@ int		savegameslot;
 char		savedescription[32]; 
  
  
-#define	BODYQUESIZE	32
 
 mobj_t*		bodyque[BODYQUESIZE]; 
 int		bodyqueslot; 
@@ -517,6 +530,14 @@ boolean G_Responder (event_t* ev)
 	return true; 
     }
     
+    // seek through the demo with -keyframes
+    if (demoplayback && keyframetics && ev->type == ev_keydown
+	&& (ev->data1 == KEY_LEFTARROW || ev->data1 == KEY_RIGHTARROW))
+    {
+	G_SeekDemoStep (ev->data1 == KEY_LEFTARROW ? -1 : 1);
+	return true;
+    }
+    
     // any other key pops up menu if in demos
     if (gameaction == ga_nothing && !singledemo && 
 	(demoplayback || gamestate == GS_DEMOSCREEN) 
@@ -598,6 +619,373 @@ boolean G_Responder (event_t* ev)
  
  
  
+//
+// SYNC HASH
+// With -synchash the level is hashed every tic by P_SyncHash.
+// Netgames send the folded hash in the ticcmd consistancy field
+// instead of the player x, so all nodes need the flag.
+// Recorded demos get a .hsh file with the sums for each tic,
+// and playback compares against it when the file is present.
+//
+#define SYNCTICSIZE	(NUMSYNCHASH*4)
+
+static unsigned	syncsums[NUMSYNCHASH];
+static int	synctic;	// tics since the demo started
+static byte*	syncbuffer;	// sums recorded or loaded
+static int	synclength;
+static int	syncsize;
+static int	syncdivergetic;
+static int	syncdivergemask; // 1<<synchash_e for each that differed
+static boolean	syncquiet;	// -verifydemos reports on its own
+
+
+//
+// G_SyncHashValue
+// The sums combined into one.
+//
+static unsigned G_SyncHashValue (void)
+{
+    unsigned	h;
+    int		i;
+	
+    h = 0;
+    for (i=0 ; i<NUMSYNCHASH ; i++)
+	h = (h<<5 | h>>27) ^ syncsums[i];
+    return h;
+}
+
+
+//
+// G_FoldSyncHash
+// The sums folded down to a consistancy value.
+//
+static short G_FoldSyncHash (void)
+{
+    unsigned	h;
+	
+    h = G_SyncHashValue ();
+    return (short)(h ^ h>>16);
+}
+
+
+//
+// G_SyncHashName
+// The .hsh file that goes with a demo name.
+//
+static void
+G_SyncHashName
+( char*		name,
+  char*		demo )
+{
+    char*	dot;
+	
+    strcpy (name, demo);
+    dot = strrchr (name, '.');
+    if (dot && !strcmp (dot, ".lmp"))
+	*dot = 0;
+    strcat (name, ".hsh");
+}
+
+
+//
+// G_StartSyncHash
+// Resets the tic count at the start of a demo,
+// and loads the recorded sums for playback.
+//
+static void G_StartSyncHash (char* demo)
+{
+    char	name[1024];
+    FILE*	f;
+    int		length;
+	
+    synctic = 0;
+    synclength = 0;
+    syncdivergetic = -1;
+    syncdivergemask = 0;
+	
+    if (!demoplayback)
+	return;
+	
+    G_SyncHashName (name, demo);
+    f = fopen (name, "rb");
+    if (!f)
+	return;
+	
+    fseek (f, 0, SEEK_END);
+    length = ftell (f);
+    fseek (f, 0, SEEK_SET);
+    if (length > syncsize)
+    {
+	syncbuffer = realloc (syncbuffer, length);
+	if (!syncbuffer)
+	    I_Error ("G_StartSyncHash: couldn't grow to %i", length);
+	syncsize = length;
+    }
+    synclength = fread (syncbuffer, 1, length, f);
+    fclose (f);
+    if (!syncquiet)
+	printf ("synchash: checking against %s\n", name);
+}
+
+
+//
+// G_SyncHashTic
+// Hashes the state the coming tic starts from,
+// then records it or checks it against the demo.
+//
+static void G_SyncHashTic (void)
+{
+    byte*	p;
+    unsigned	sum;
+    int		i;
+	
+    if (gamestate == GS_LEVEL)
+	P_SyncHash (syncsums);
+    else
+	memset (syncsums, 0, sizeof(syncsums));
+	
+    if (demorecording)
+    {
+	if (synclength + SYNCTICSIZE > syncsize)
+	{
+	    syncsize = syncsize ? syncsize*2 : SYNCTICSIZE*4096;
+	    syncbuffer = realloc (syncbuffer, syncsize);
+	    if (!syncbuffer)
+		I_Error ("G_SyncHashTic: couldn't grow to %i", syncsize);
+	}
+	p = syncbuffer + synclength;
+	for (i=0 ; i<NUMSYNCHASH ; i++)
+	{
+	    *p++ = syncsums[i];
+	    *p++ = syncsums[i]>>8;
+	    *p++ = syncsums[i]>>16;
+	    *p++ = syncsums[i]>>24;
+	}
+	synclength += SYNCTICSIZE;
+    }
+    else if (demoplayback
+	     && !syncdivergemask
+	     && (synctic+1)*SYNCTICSIZE <= synclength)
+    {
+	p = syncbuffer + synctic*SYNCTICSIZE;
+	for (i=0 ; i<NUMSYNCHASH ; i++, p+=4)
+	{
+	    sum = p[0] | p[1]<<8 | p[2]<<16 | (unsigned)p[3]<<24;
+	    if (sum != syncsums[i])
+		syncdivergemask |= 1<<i;
+	}
+	if (syncdivergemask)
+	{
+	    syncdivergetic = synctic;
+	    if (!syncquiet)
+	    {
+		printf ("synchash: diverged at tic %i in", synctic);
+		for (i=0 ; i<NUMSYNCHASH ; i++)
+		    if (syncdivergemask & 1<<i)
+			printf (" %s", synchashnames[i]);
+		printf ("\n");
+	    }
+	}
+    }
+	
+    synctic++;
+}
+
+
+//
+// G_EndSyncHash
+// Reports a playback that never diverged,
+// or writes the sums of a recording.
+//
+static void G_EndSyncHash (void)
+{
+    char	name[1024];
+	
+    if (demoplayback && synclength && !syncdivergemask)
+    {
+	if (synctic*SYNCTICSIZE > synclength)
+	    printf ("synchash: %i tics match, hash file ends before tic %i\n",
+		    synclength/SYNCTICSIZE, synctic);
+	else
+	    printf ("synchash: %i tics match\n", synctic);
+    }
+	
+    if (demorecording)
+    {
+	G_SyncHashName (name, demoname);
+	M_WriteFile (name, syncbuffer, synclength);
+    }
+	
+    synclength = 0;
+}
+
+
+
+//
+// KEYFRAMES
+// With -keyframes, demo playback takes a snapshot of the level
+// every keyframetics tics. G_SeekDemo restores the last one
+// before the target and plays the rest without drawing, so a
+// seek costs at most keyframetics tics of simulation.
+//
+// Snapshots hold live pointers (states, thinker functions),
+// so they only last for this run of the program.
+//
+#define SEEKSTEP	(10*TICRATE)	// arrow keys in a demo
+
+typedef struct
+{
+    int		tic;		// demo tic it was taken at
+    int		offset;		// demo_p - demobuffer
+    savestate_t	state;
+    
+} keyframe_t;
+
+int			keyframetics;	// 0 if off
+
+static keyframe_t*	keyframes;
+static int		numkeyframes;
+static int		maxkeyframes;
+
+static int	demotic;	// tics played since the demo started
+static int	demotics;	// tics in the whole demo
+static int	demostarttic;	// gametic at demo tic 0
+static int	seektic = -1;	// pending G_SeekDemo
+
+
+//
+// G_StartKeyframes
+// Called with demo_p at the first ticcmd.
+//
+static void G_StartKeyframes (void)
+{
+    byte*	p;
+    int		stride;
+    int		i;
+	
+    numkeyframes = 0;
+    demotic = 0;
+    demostarttic = gametic;
+	
+    stride = 0;
+    for (i=0 ; i<MAXPLAYERS ; i++)
+	if (playeringame[i])
+	    stride += 4;
+	
+    demotics = 0;
+    for (p = demo_p ; p <= demoend-stride && *p != DEMOMARKER ; p += stride)
+	demotics++;
+}
+
+
+//
+// G_KeyframeTic
+// Takes the snapshot for this tic if it is due,
+// and not already taken on an earlier pass.
+//
+static void G_KeyframeTic (void)
+{
+    keyframe_t*	kf;
+    int		oldmax;
+	
+    if (gamestate == GS_LEVEL
+	&& !(demotic % keyframetics)
+	&& (!numkeyframes || keyframes[numkeyframes-1].tic < demotic))
+    {
+	if (numkeyframes == maxkeyframes)
+	{
+	    oldmax = maxkeyframes;
+	    maxkeyframes = maxkeyframes ? maxkeyframes*2 : 64;
+	    keyframes = realloc (keyframes, maxkeyframes*sizeof(*keyframes));
+	    if (!keyframes)
+		I_Error ("G_KeyframeTic: couldn't grow to %i", maxkeyframes);
+	    memset (keyframes+oldmax, 0,
+		    (maxkeyframes-oldmax)*sizeof(*keyframes));
+	}
+	kf = &keyframes[numkeyframes++];
+	kf->tic = demotic;
+	kf->offset = demo_p - demobuffer;
+	G_SnapshotState (&kf->state);
+    }
+	
+    demotic++;
+}
+
+
+//
+// G_SeekDemo
+//
+void G_SeekDemo (int tic)
+{
+    seektic = tic < 0 ? 0 : tic;
+}
+
+
+//
+// G_SeekDemoStep
+// Moves a SEEKSTEP from the pending seek,
+// or from where the demo is.
+//
+static void G_SeekDemoStep (int steps)
+{
+    G_SeekDemo ((seektic >= 0 ? seektic : demotic) + steps*SEEKSTEP);
+}
+
+
+//
+// G_DoSeekDemo
+// Called from D_DoomLoop outside of TryRunTics,
+// as it moves gametic. A seek asked for before
+// the demo starts waits for it.
+//
+void G_DoSeekDemo (void)
+{
+    keyframe_t*	kf;
+    int		tic;
+    int		oldgametic;
+    boolean	oldfast;
+    int		i;
+	
+    if (seektic < 0 || !demoplayback || !keyframetics)
+	return;
+	
+    tic = seektic;
+    seektic = -1;
+    if (tic > demotics-1)
+	tic = demotics-1;
+    oldgametic = gametic;
+	
+    // the last keyframe at or before the target, if
+    // going back or if it is ahead of where we are
+    for (i=numkeyframes-1 ; i>=0 && keyframes[i].tic > tic ; i--)
+	;
+    if (i >= 0 && (tic < demotic || keyframes[i].tic > demotic))
+    {
+	kf = &keyframes[i];
+	G_RestoreState (&kf->state);
+	demo_p = demobuffer + kf->offset;
+	demotic = synctic = kf->tic;
+	gametic = demostarttic + kf->tic;
+    }
+    else if (tic < demotic)
+	return;
+
+    // gametic has to line up with the demo tic,
+    // A_Tracer goes by it
+    oldfast = fastdemo;
+    fastdemo = true;
+    while (demotic < tic && demoplayback)
+    {
+	G_Ticker ();
+	gametic++;
+    }
+    fastdemo = oldfast;
+	
+    D_ShiftTics (gametic - oldgametic);
+}
+
+
+
 //
 // G_Ticker
 // Make ticcmd_ts for the players.
@@ -651,6 +1039,11 @@ void G_Ticker (void)
 	} 
     }
     
+    if (synchash)
+	G_SyncHashTic ();
+    if (keyframetics && demoplayback)
+	G_KeyframeTic ();
+	
     // get commands, check consistancy,
     // and build new consistancy check
     buf = (gametic/ticdup)%BACKUPTICS; 
@@ -686,7 +1079,9 @@ void G_Ticker (void)
 		    I_Error ("consistency failure (%i should be %i)",
 			     cmd->consistancy, consistancy[i][buf]); 
 		} 
-		if (players[i].mo) 
+		if (synchash)
+		    consistancy[i][buf] = G_FoldSyncHash ();
+		else if (players[i].mo) 
 		    consistancy[i][buf] = players[i].mo->x; 
 		else 
 		    consistancy[i][buf] = rndindex; 
@@ -728,6 +1123,8 @@ void G_Ticker (void)
     { 
       case GS_LEVEL: 
 	P_Ticker (); 
+	if (fastdemo)
+	    break;
 	ST_Ticker (); 
 	AM_Ticker (); 
 	HU_Ticker ();            
@@ -1252,6 +1649,104 @@ void G_DoLoadGame (void)
 } 
  
 
+
+//
+// G_SnapshotState
+// Like a savegame, but kept in memory, with
+// no size limit and every thinker, so a restore
+// plays on exactly as the game did from there.
+// state->data grows as needed.
+//
+void G_SnapshotState (savestate_t* state)
+{
+    int		size;
+    int		i;
+    byte*	data;
+	
+    if (gamestate != GS_LEVEL)
+	I_Error ("G_SnapshotState: not in a level");
+    
+    size = 4 + MAXPLAYERS + P_StateSize ();
+    if (state->size < size)
+    {
+	i = state->size ? state->size : SAVEGAMESIZE;
+	while (i < size)
+	    i *= 2;
+	
+	data = realloc (state->data, i);
+	if (!data)
+	    I_Error ("G_SnapshotState: couldn't grow to %i", i);
+	state->data = data;
+	state->size = i;
+    }
+
+    save_p = state->data;
+    *save_p++ = gameskill;
+    *save_p++ = gameepisode;
+    *save_p++ = gamemap;
+    *save_p++ = gameaction;
+    for (i=0 ; i<MAXPLAYERS ; i++)
+	*save_p++ = playeringame[i];
+
+    P_ArchiveState ();
+    
+    state->length = save_p - state->data;
+}
+
+
+//
+// G_RestoreState
+// Loads the level again only if another
+// one is being played.
+//
+void G_RestoreState (savestate_t* state)
+{
+    skill_t	skill;
+    int		episode;
+    int		map;
+    int		action;
+    int		i;
+    boolean	reload;
+    boolean	playback;
+    boolean	user;
+	
+    save_p = state->data;
+    skill = *save_p++;
+    episode = *save_p++;
+    map = *save_p++;
+    action = *save_p++;
+
+    reload = gamestate != GS_LEVEL
+	|| skill != gameskill
+	|| episode != gameepisode
+	|| map != gamemap;
+    
+    for (i=0 ; i<MAXPLAYERS ; i++, save_p++)
+    {
+	if (playeringame[i] != *save_p)
+	    reload = true;
+	playeringame[i] = *save_p;
+    }
+
+    // G_InitNew starts a live game, but a demo
+    // seek has to carry on playing the demo
+    if (reload)
+    {
+	playback = demoplayback;
+	user = usergame;
+	G_InitNew (skill, episode, map);
+	demoplayback = playback;
+	usergame = user;
+    }
+    
+    P_UnArchiveState ();
+    gameaction = action;
+    
+    if (save_p - state->data != state->length)
+	I_Error ("G_RestoreState: bad state");
+}
+ 
+
 //
 // G_SaveGame
 // Called by the menu task.
@@ -1485,12 +1980,10 @@ G_InitNew
 //
 // DEMO RECORDING 
 // 
-#define DEMOMARKER		0x80
-
 
 void G_ReadDemoTiccmd (ticcmd_t* cmd) 
 { 
-    if (*demo_p == DEMOMARKER) 
+    if (demo_p > demoend - 4 || *demo_p == DEMOMARKER) 
     {
 	// end of demo data stream 
 	G_CheckDemoStatus (); 
@@ -1564,6 +2057,9 @@ void G_BeginRecording (void)
 	 
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	*demo_p++ = playeringame[i]; 		 
+
+    if (synchash)
+	G_StartSyncHash (demoname);
 } 
  
 
@@ -1579,18 +2075,26 @@ void G_DeferedPlayDemo (char* name)
     gameaction = ga_playdemo; 
 } 
  
-void G_DoPlayDemo (void) 
+//
+// G_StartPlayback
+// Reads the demo header and starts its level.
+// Returns false if the demo can't be played.
+//
+static boolean
+G_StartPlayback
+( byte*		buffer,
+  int		length )
 { 
     skill_t skill; 
     int             i, episode, map; 
 	 
-    gameaction = ga_nothing; 
-    demobuffer = demo_p = W_CacheLumpName (defdemoname, PU_STATIC); 
-    if ( *demo_p++ != VERSION)
+    demobuffer = demo_p = buffer; 
+    demoend = buffer + length;
+    if (length < 9+MAXPLAYERS || *demo_p++ != VERSION)
     {
       fprintf( stderr, "Demo is from a different game version!\n");
       gameaction = ga_nothing;
-      return;
+      return false;
     }
     
     skill = *demo_p++; 
@@ -1617,21 +2121,79 @@ void G_DoPlayDemo (void)
 
     usergame = false; 
     demoplayback = true; 
+    return true;
+}
+
+
+void G_DoPlayDemo (void) 
+{ 
+    int		lump;
+	
+    gameaction = ga_nothing; 
+    lump = W_GetNumForName (defdemoname);
+    if (!G_StartPlayback (W_CacheLumpNum (lump, PU_STATIC),
+			  W_LumpLength (lump)))
+	return;
+
+    if (synchash)
+	G_StartSyncHash (defdemoname);
+    if (keyframetics)
+	G_StartKeyframes ();
+
+    if (fastdemo)
+    {
+	fastdemostart = I_GetTimeUS ();
+	fastdemotic = gametic;
+    }
+    timedemotic = gametic;
 } 
 
 //
 // G_TimeDemo 
+// Plays the demos in turn, timing every frame.
+// The report is written at exit, see m_bench.c.
 //
-void G_TimeDemo (char* name) 
+void
+G_TimeDemo
+( char**	names,
+  int		count ) 
 { 	 
+    int		p;
+	
     nodrawers = M_CheckParm ("-nodraw"); 
     noblit = M_CheckParm ("-noblit"); 
     timingdemo = true; 
     singletics = true; 
 
-    defdemoname = name; 
+    p = M_CheckParm ("-benchout");
+    if (p && p < myargc-1)
+	M_BenchInit (myargv[p+1]);
+    else
+	M_BenchInit ("timedemo.json");
+	
+    timedemonames = names;
+    numtimedemos = count;
+    timedemonum = 0;
+    defdemoname = names[0]; 
     gameaction = ga_playdemo; 
 } 
+
+
+//
+// G_FastDemo
+// Plays a demo through G_Ticker alone:
+// no drawing, no sound, no frame pacing.
+//
+void G_FastDemo (char* name) 
+{
+    nodrawers = true;
+    noblit = true;
+    fastdemo = true;
+    singledemo = true;
+
+    defdemoname = name; 
+    gameaction = ga_playdemo; 
+}
  
  
 /* 
@@ -1646,13 +2208,37 @@ void G_TimeDemo (char* name)
  
 boolean G_CheckDemoStatus (void) 
 { 
-    int             endtime; 
+    long long       usecs;
+    int             tics;
 	 
-    if (timingdemo) 
+    if (verifyresult && demoplayback)
+    {
+	G_EndVerify ();
+	return true;
+    }
+	
+    if (synchash && (demoplayback || demorecording))
+	G_EndSyncHash ();
+	
+    if (fastdemo && demoplayback)
+    {
+	usecs = I_GetTimeUS () - fastdemostart;
+	tics = gametic - fastdemotic;
+	if (usecs < 1)
+	    usecs = 1;
+	printf ("fastdemo: %i gametics in %lld usecs (%.1f tics/sec)\n",
+		tics, usecs, tics * 1000000.0 / usecs);
+	
+	// graphics never started, and a benchmark
+	// run shouldn't rewrite the config
+	exit (0);
+    }
+	
+    if (timingdemo && demoplayback) 
     { 
-	endtime = I_GetTime (); 
-	I_Error ("timed %i gametics in %i realtics",gametic 
-		 , endtime-starttime); 
+	M_BenchEndDemo (defdemoname, gametic - timedemotic);
+	if (timedemonum+1 >= numtimedemos)
+	    I_Quit ();
     } 
 	 
     if (demoplayback) 
@@ -1670,7 +2256,10 @@ boolean G_CheckDemoStatus (void)
 	fastparm = false;
 	nomonsters = false;
 	consoleplayer = 0;
-	D_AdvanceDemo (); 
+	if (timingdemo)
+	    G_DeferedPlayDemo (timedemonames[++timedemonum]);
+	else
+	    D_AdvanceDemo (); 
 	return true; 
     } 
  
@@ -1688,3 +2277,308 @@ boolean G_CheckDemoStatus (void)
  
  
  
+
+
+
+//
+// ROLLOUTS
+//
+
+//
+// G_RunRollout
+// Plays one ticcmd stream from the current state.
+//
+static void
+G_RunRollout
+( byte*		stream,
+  int		length,
+  int		tics,
+  rollout_t*	result )
+{
+    byte*	end;
+    ticcmd_t*	cmd;
+    player_t*	player;
+    int		buf;
+    int		i;
+	
+    end = stream + length;
+    player = &players[consoleplayer];
+    memset (result, 0, sizeof(*result));
+    
+    while (result->tics < tics)
+    {
+	buf = (gametic/ticdup)%BACKUPTICS;
+	for (i=0 ; i<MAXPLAYERS ; i++)
+	{
+	    if (!playeringame[i])
+		continue;
+	    if (end - stream < 4 || *stream == DEMOMARKER)
+		goto done;
+	    
+	    cmd = &netcmds[i][buf];
+	    memset (cmd, 0, sizeof(*cmd));
+	    cmd->forwardmove = ((signed char)*stream++);
+	    cmd->sidemove = ((signed char)*stream++);
+	    cmd->angleturn = ((unsigned char)*stream++)<<8;
+	    cmd->buttons = (unsigned char)*stream++;
+	}
+
+	G_Ticker ();
+	gametic++;
+	result->tics++;
+
+	// stop before the intermission
+	if (gameaction == ga_completed || gameaction == ga_victory)
+	{
+	    result->exited = true;
+	    break;
+	}
+	if (player->playerstate == PST_DEAD)
+	{
+	    result->dead = true;
+	    break;
+	}
+    }
+
+  done:
+    result->health = player->health;
+    result->killcount = player->killcount;
+    result->itemcount = player->itemcount;
+    result->secretcount = player->secretcount;
+}
+
+
+//
+// G_Rollout
+// Branches the level being played into one child
+// process per ticcmd stream file. The children share
+// this state copy-on-write, so a branch costs page
+// faults instead of a savegame. Each one plays its
+// stream through G_Ticker, with nothing drawn, for up
+// to tics tics, until the level is left or the console
+// player dies, and sends its rollout_t back on a pipe.
+// A stream holds demo ticcmds for every player in the
+// game, as in a demo after its header.
+//
+void
+G_Rollout
+( int		numstreams,
+  char**	streams,
+  int		tics,
+  rollout_t*	results )
+{
+    int*	fds;
+    int*	pids;
+    int		i;
+    int		length;
+    byte*	stream;
+	
+    if (gamestate != GS_LEVEL)
+	I_Error ("G_Rollout: not in a level");
+
+    fds = malloc (numstreams*sizeof(*fds));
+    pids = malloc (numstreams*sizeof(*pids));
+    if (!fds || !pids)
+	I_Error ("G_Rollout: couldn't allocate %i rollouts", numstreams);
+
+    for (i=0 ; i<numstreams ; i++)
+    {
+	pids[i] = I_ForkPipe (&fds[i]);
+	if (!pids[i])
+	{
+	    // child
+	    length = M_ReadFile (streams[i], &stream);
+	    G_RunRollout (stream, length, tics, &results[i]);
+	    I_WritePipe (fds[i], &results[i], sizeof(results[i]));
+	    I_ExitChild ();
+	}
+    }
+
+    for (i=0 ; i<numstreams ; i++)
+    {
+	length = I_ReadPipe (fds[i], &results[i], sizeof(results[i]));
+	I_WaitChild (pids[i]);
+	
+	if (length != sizeof(results[i]))
+	    I_Error ("G_Rollout: %s failed", streams[i]);
+    }
+
+    free (fds);
+    free (pids);
+}
+
+
+
+//
+// VERIFYING
+//
+
+//
+// G_EndVerify
+// Called from G_CheckDemoStatus when the demo
+// being verified runs out.
+//
+static void G_EndVerify (void)
+{
+    demoverify_t*	result;
+	
+    result = verifyresult;
+    result->truncated = demo_p >= demoend || *demo_p != DEMOMARKER;
+    result->tics = gametic - timedemotic;
+    result->episode = gameepisode;
+    result->map = gamemap;
+    result->gamestate = gamestate;
+	
+    // G_SyncHashTic has already hashed this tic
+    result->hash = G_SyncHashValue ();
+    result->hashedtics = synclength / SYNCTICSIZE;
+    result->desynctic = syncdivergetic;
+    result->desyncmask = syncdivergemask;
+	
+    demoplayback = false;
+}
+
+
+//
+// G_VerifyDemo
+// Plays one demo to its end with nothing drawn or heard.
+//
+static void
+G_VerifyDemo
+( char*		name,
+  demoverify_t*	result )
+{
+    byte*	buffer;
+    int		length;
+    int		lump;
+    int		i;
+    boolean	dead[MAXPLAYERS];
+	
+    memset (result, 0, sizeof(*result));
+    result->desynctic = -1;
+    result->failed = true;
+	
+    // a file if it looks like a path, else a lump
+    if (strchr (name, '.') || strchr (name, '/'))
+	length = M_ReadFile (name, &buffer);
+    else
+    {
+	lump = W_CheckNumForName (name);
+	if (lump == -1)
+	    return;
+	buffer = W_CacheLumpNum (lump, PU_STATIC);
+	length = W_LumpLength (lump);
+    }
+
+    fastdemo = true;
+    synchash = true;
+    syncquiet = true;
+    defdemoname = name;
+    if (!G_StartPlayback (buffer, length))
+	return;
+    G_StartSyncHash (name);
+	
+    result->failed = false;
+    verifyresult = result;
+    timedemotic = gametic;
+    memset (dead, 0, sizeof(dead));
+	
+    while (1)
+    {
+	G_Ticker ();
+	if (!demoplayback)
+	    break;
+	gametic++;
+	
+	if (gameaction == ga_completed)
+	    result->exits++;
+	for (i=0 ; i<MAXPLAYERS ; i++)
+	{
+	    if (!playeringame[i])
+		continue;
+	    if (players[i].playerstate == PST_DEAD && !dead[i])
+		result->deaths++;
+	    dead[i] = players[i].playerstate == PST_DEAD;
+	}
+    }
+}
+
+
+//
+// G_VerifyDemos
+// A pool of at most jobs children, one per demo.
+// A child writes its result and exits, the result
+// fits in the pipe so it never waits on the parent.
+//
+typedef struct
+{
+    int		pid;		// 0 if free
+    int		fd;
+    int		demo;
+    
+} verifyjob_t;
+
+void
+G_VerifyDemos
+( int		numdemos,
+  char**	demos,
+  int		jobs,
+  demoverify_t*	results )
+{
+    verifyjob_t*	pool;
+    verifyjob_t*	job;
+    int			next;
+    int			running;
+    int			pid;
+    int			length;
+	
+    if (jobs < 1)
+	jobs = 1;
+    pool = malloc (jobs*sizeof(*pool));
+    if (!pool)
+	I_Error ("G_VerifyDemos: couldn't allocate %i jobs", jobs);
+    memset (pool, 0, jobs*sizeof(*pool));
+
+    next = running = 0;
+    while (next < numdemos || running)
+    {
+	if (next < numdemos && running < jobs)
+	{
+	    for (job = pool ; job->pid ; job++)
+		;
+	    job->demo = next++;
+	    job->pid = I_ForkPipe (&job->fd);
+	    if (!job->pid)
+	    {
+		// child
+		G_VerifyDemo (demos[job->demo], &results[job->demo]);
+		I_WritePipe (job->fd, &results[job->demo],
+			     sizeof(results[job->demo]));
+		I_ExitChild ();
+	    }
+	    running++;
+	    continue;
+	}
+
+	pid = I_WaitAnyChild ();
+	if (pid == -1)
+	    I_Error ("G_VerifyDemos: lost %i children", running);
+	for (job = pool ; job < pool+jobs && job->pid != pid ; job++)
+	    ;
+	if (job == pool+jobs)
+	    continue;
+	
+	length = I_ReadPipe (job->fd, &results[job->demo],
+			     sizeof(results[job->demo]));
+	if (length != sizeof(results[job->demo]))
+	{
+	    memset (&results[job->demo], 0, sizeof(results[job->demo]));
+	    results[job->demo].failed = true;
+	    results[job->demo].desynctic = -1;
+	}
+	job->pid = 0;
+	running--;
+    }
+
+    free (pool);
+}
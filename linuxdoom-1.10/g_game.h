@@ -48,6 +48,73 @@ void G_LoadGame (char* name);
 
 void G_DoLoadGame (void);
 
+// A snapshot of the game, held in memory.
+// The caller owns it, zero it before first use
+// and free() data when done.
+typedef struct
+{
+    byte*	data;
+    int		length;		// bytes used
+    int		size;		// bytes allocated
+    
+} savestate_t;
+
+// Save / restore the level being played,
+// for going back to an earlier tic.
+void G_SnapshotState (savestate_t* state);
+void G_RestoreState (savestate_t* state);
+
+// What one rollout came to.
+typedef struct
+{
+    int		tics;		// tics played
+    int		health;
+    int		killcount;
+    int		itemcount;
+    int		secretcount;
+    boolean	exited;		// level completed
+    boolean	dead;
+    
+} rollout_t;
+
+// Plays each ticcmd stream file from the current
+// level state in its own forked child, headless.
+void
+G_Rollout
+( int		numstreams,
+  char**	streams,
+  int		tics,
+  rollout_t*	results );
+
+//
+// Result of playing one demo through, see G_VerifyDemos.
+//
+typedef struct
+{
+    boolean	failed;		// couldn't be loaded or crashed
+    boolean	truncated;	// data ran out without a DEMOMARKER
+    int		tics;		// tics played
+    int		exits;		// levels completed
+    int		deaths;		// any player
+    int		episode;	// where the demo ended
+    int		map;
+    int		gamestate;
+    unsigned	hash;		// world hash at the end, see P_SyncHash
+    int		hashedtics;	// tics covered by the .hsh file, 0 if none
+    int		desynctic;	// first tic off the .hsh file, or -1
+    int		desyncmask;	// 1<<synchash_e for each part that differed
+    
+} demoverify_t;
+
+// Plays each demo lump or file to its end in its own
+// forked child, headless, jobs children at a time.
+void
+G_VerifyDemos
+( int		numdemos,
+  char**	demos,
+  int		jobs,
+  demoverify_t*	results );
+
 // Called by M_Responder.
 void G_SaveGame (int slot, char* description);
 
@@ -57,7 +124,17 @@ void G_RecordDemo (char* name);
 void G_BeginRecording (void);
 
 void G_PlayDemo (char* name);
-void G_TimeDemo (char* name);
+void
+G_TimeDemo
+( char**	names,
+  int		count );
+void G_FastDemo (char* name);
+
+// Jumps the demo being played to the given tic,
+// from the nearest keyframe. Done by G_DoSeekDemo
+// at the start of the next frame.
+void G_SeekDemo (int tic);
+void G_DoSeekDemo (void);
 boolean G_CheckDemoStatus (void);
 
 void G_ExitLevel (void);
@@ -672,6 +672,13 @@ I_SubmitSound(void)
 }
 
 
+int I_GetMixBuffer (signed short** buffer)
+{
+  *buffer = mixbuffer;
+  return SAMPLECOUNT;
+}
+
+
 
 void
 I_UpdateSoundParams
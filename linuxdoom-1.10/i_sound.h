@@ -44,6 +44,10 @@ void I_InitSound();
 void I_UpdateSound(void);
 void I_SubmitSound(void);
 
+// The samples I_UpdateSound last mixed, as
+// interleaved stereo. Returns the frame count.
+int I_GetMixBuffer (signed short** buffer);
+
 // ... shut down and relase at program termination.
 void I_ShutdownSound(void);
 
@@ -325,6 +325,16 @@ void I_SubmitSound(void)
 }
 
 
+//
+// I_GetMixBuffer
+//
+int I_GetMixBuffer(signed short** buffer)
+{
+    *buffer = mixbuffer;
+    return SAMPLECOUNT;
+}
+
+
 //
 // I_UpdateSoundParams
 //
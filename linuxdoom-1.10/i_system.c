@@ -30,6 +30,9 @@ rcsid[] = "$Id: m_bbox.c,v 1.1 1997/02/03 22:45:10 b1 Exp $";
 
 #include <stdarg.h>
 #include <sys/time.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 #include "doomdef.h"
@@ -101,6 +104,24 @@ int  I_GetTime (void)
 
 
 
+//
+// I_GetTimeUS
+// returns time in microseconds, for profiling.
+// CLOCK_MONOTONIC does not step with NTP or settimeofday.
+//
+long long I_GetTimeUS (void)
+{
+    struct timespec	tp;
+    static time_t	basetime=0;
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    if (!basetime)
+	basetime = tp.tv_sec;
+    return (long long)(tp.tv_sec-basetime)*1000000 + tp.tv_nsec/1000;
+}
+
+
+
 //
 // I_Init
 //
@@ -154,6 +175,10 @@ byte*	I_AllocLow(int length)
 }
 
 
+// Set in the children of I_ForkPipe.
+static boolean	forkedchild;
+
+
 //
 // I_Error
 //
@@ -172,6 +197,11 @@ void I_Error (char *error, ...)
 
     fflush( stderr );
 
+    // A forked child leaves the shutdown
+    // and the exit handlers to the parent.
+    if (forkedchild)
+	_exit (-1);
+
     // Shutdown. Here might be other errors.
     if (demorecording)
 	G_CheckDemoStatus();
@@ -181,3 +211,103 @@ void I_Error (char *error, ...)
     
     exit(-1);
 }
+
+
+
+//
+// I_ForkPipe
+//
+int I_ForkPipe (int* fd)
+{
+    int		fds[2];
+    pid_t	pid;
+	
+    // or buffered output would go out twice
+    fflush (stdout);
+    fflush (stderr);
+    
+    if (pipe (fds) == -1)
+	I_Error ("I_ForkPipe: pipe failed");
+    
+    pid = fork ();
+    if (pid == -1)
+	I_Error ("I_ForkPipe: fork failed");
+
+    if (pid)
+    {
+	close (fds[1]);
+	*fd = fds[0];
+    }
+    else
+    {
+	close (fds[0]);
+	*fd = fds[1];
+	forkedchild = true;
+    }
+    return pid;
+}
+
+
+//
+// I_ReadPipe
+//
+int I_ReadPipe (int fd, void* buf, int length)
+{
+    int		got;
+    int		n;
+
+    for (got = 0 ; got < length ; got += n)
+    {
+	n = read (fd, (byte *)buf + got, length - got);
+	if (n <= 0)
+	    break;
+    }
+    close (fd);
+    return got;
+}
+
+
+//
+// I_WritePipe
+//
+int I_WritePipe (int fd, void* buf, int length)
+{
+    int		put;
+    int		n;
+
+    for (put = 0 ; put < length ; put += n)
+    {
+	n = write (fd, (byte *)buf + put, length - put);
+	if (n <= 0)
+	    break;
+    }
+    close (fd);
+    return put;
+}
+
+
+//
+// I_WaitChild
+//
+void I_WaitChild (int pid)
+{
+    waitpid (pid, NULL, 0);
+}
+
+
+//
+// I_WaitAnyChild
+//
+int I_WaitAnyChild (void)
+{
+    return waitpid (-1, NULL, 0);
+}
+
+
+//
+// I_ExitChild
+//
+void I_ExitChild (void)
+{
+    _exit (0);
+}
@@ -44,6 +44,10 @@ byte*	I_ZoneBase (int *size);
 // returns current time in tics.
 int I_GetTime (void);
 
+// Returns a monotonic wall clock in microseconds.
+// Used for profiling, load-time statistics and benchmarks.
+long long I_GetTimeUS (void);
+
 
 //
 // Called by D_DoomLoop,
@@ -89,6 +93,27 @@ void I_Tactile (int on, int off, int total);
 void I_Error (char *error, ...);
 
 
+// Starts a child process with a pipe back to this one,
+// returns its pid, or 0 in the child. *fd is the read end
+// in the parent and the write end in the child. I_Error
+// in the child exits without the parent's shutdown.
+int  I_ForkPipe (int* fd);
+
+// Move length bytes over a pipe, then close it.
+// Return how many bytes got through.
+int  I_ReadPipe (int fd, void* buf, int length);
+int  I_WritePipe (int fd, void* buf, int length);
+
+void I_WaitChild (int pid);
+
+// Waits for whichever child ends first,
+// returns its pid, or -1 if there are none.
+int  I_WaitAnyChild (void);
+
+// Leaves a child without any of the I_Quit shutdown.
+void I_ExitChild (void);
+
+
 #endif
 //-----------------------------------------------------------------------------
 //
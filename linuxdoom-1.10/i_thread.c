@@ -0,0 +1,165 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Worker thread pool, POSIX threads.
+//	Workers are started on first use and sleep
+//	between batches.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "doomtype.h"
+#include "m_argv.h"
+#include "i_system.h"
+
+#ifdef __GNUG__
+#pragma implementation "i_thread.h"
+#endif
+#include "i_thread.h"
+
+
+#define MAXTHREADS	64
+
+static int		numthreads;	// 0 until initialized
+static pthread_t	workers[MAXTHREADS];
+
+static pthread_mutex_t	joblock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	jobstart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	jobdone = PTHREAD_COND_INITIALIZER;
+
+// current batch
+static jobfunc_t	jobfunc;
+static void*		jobarg;
+static int		jobcount;
+static int		jobnext;	// next index to hand out
+static int		jobgeneration;	// bumped for every batch
+static int		jobsbusy;	// workers still in the batch
+
+
+
+//
+// I_DoJobs
+// Hands out indices until the batch is exhausted.
+//
+static void I_DoJobs (void)
+{
+    int		index;
+
+    while ( (index = __sync_fetch_and_add (&jobnext, 1)) < jobcount)
+	jobfunc (index, jobarg);
+}
+
+
+static void* I_WorkerThread (void* unused)
+{
+    int		generation;
+
+    generation = 0;
+    for (;;)
+    {
+	pthread_mutex_lock (&joblock);
+	while (generation == jobgeneration)
+	    pthread_cond_wait (&jobstart, &joblock);
+	generation = jobgeneration;
+	pthread_mutex_unlock (&joblock);
+
+	I_DoJobs ();
+
+	pthread_mutex_lock (&joblock);
+	if (!--jobsbusy)
+	    pthread_cond_signal (&jobdone);
+	pthread_mutex_unlock (&joblock);
+    }
+    return NULL;
+}
+
+
+//
+// I_NumThreads
+//
+int I_NumThreads (void)
+{
+    int		i;
+    int		p;
+
+    if (numthreads)
+	return numthreads;
+
+    p = M_CheckParm ("-threads");
+    if (p && p < myargc-1)
+	numthreads = atoi (myargv[p+1]);
+    else
+	numthreads = sysconf (_SC_NPROCESSORS_ONLN);
+
+    if (numthreads < 1)
+	numthreads = 1;
+    if (numthreads > MAXTHREADS)
+	numthreads = MAXTHREADS;
+
+    // the calling thread is one of them
+    for (i=1 ; i<numthreads ; i++)
+    {
+	if (pthread_create (&workers[i], NULL, I_WorkerThread, NULL))
+	{
+	    numthreads = i;
+	    break;
+	}
+    }
+
+    return numthreads;
+}
+
+
+//
+// I_RunJobs
+//
+void I_RunJobs (jobfunc_t func, int count, void* arg)
+{
+    int		i;
+
+    if (count <= 0)
+	return;
+
+    if (count == 1 || I_NumThreads () == 1)
+    {
+	for (i=0 ; i<count ; i++)
+	    func (i, arg);
+	return;
+    }
+
+    pthread_mutex_lock (&joblock);
+    jobfunc = func;
+    jobarg = arg;
+    jobcount = count;
+    jobnext = 0;
+    jobsbusy = numthreads-1;
+    jobgeneration++;
+    pthread_cond_broadcast (&jobstart);
+    pthread_mutex_unlock (&joblock);
+
+    I_DoJobs ();
+
+    pthread_mutex_lock (&joblock);
+    while (jobsbusy)
+	pthread_cond_wait (&jobdone, &joblock);
+    pthread_mutex_unlock (&joblock);
+}
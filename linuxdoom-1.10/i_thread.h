@@ -0,0 +1,53 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	System specific worker thread pool.
+//
+//-----------------------------------------------------------------------------
+
+
+#ifndef __I_THREAD__
+#define __I_THREAD__
+
+
+#ifdef __GNUG__
+#pragma interface
+#endif
+
+
+// A job is called once for every index in [0,count).
+// Jobs must not touch zone memory or other engine state
+//  that is not owned by their index.
+typedef void (*jobfunc_t) (int index, void* arg);
+
+
+// Number of threads I_RunJobs spreads work over,
+//  including the calling thread.
+// Set with -threads <n>, defaults to the number of CPUs.
+int I_NumThreads (void);
+
+// Runs func for every index and returns when all are done.
+// Runs serially if there is only one thread.
+void I_RunJobs (jobfunc_t func, int count, void* arg);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
@@ -177,6 +177,10 @@ int xlatekey(void)
 
 void I_ShutdownGraphics(void)
 {
+  // headless runs never open the display
+  if (!image)
+    return;
+
   if (doShm)
   {
     if (!XShmDetach(X_display, &X_shminfo))
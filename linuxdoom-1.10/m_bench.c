@@ -0,0 +1,382 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// $Log:$
+//
+// DESCRIPTION:
+//	Timedemo frame timing.
+//	Every frame is timed with I_GetTimeUS and split into
+//	phases by M_BenchLap calls along the game loop.
+//	At exit the mean, p50, p95, p99 and max of each phase
+//	are written per demo and over all demos.
+//
+//-----------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "i_system.h"
+#include "m_bench.h"
+
+
+boolean		benchframes;
+
+typedef struct
+{
+    int		time[NUMBENCHPHASES+1];	// usecs, the last is the total
+    
+} benchframe_t;
+
+typedef struct
+{
+    char*	name;
+    int		gametics;
+    int		firstframe;
+    int		numframes;
+    
+} benchdemo_t;
+
+static char*		benchname;
+
+static benchframe_t*	frames;
+static int		numframes;
+static int		maxframes;
+
+static benchdemo_t*	demos;
+static int		numdemos;
+static int		maxdemos;
+
+static int		demofirst;	// first frame of the running demo
+static boolean		inframe;
+static long long	laptime;
+static benchframe_t	frame;
+
+static int*		sorted;		// scratch for the percentiles
+static int		maxsorted;
+
+static char*	phasenames[NUMBENCHPHASES+1] =
+{
+    "playsim", "bsp", "planes", "masked", "blit", "sound", "other",
+    "total"
+};
+
+
+//
+// M_BenchInit
+//
+void M_BenchInit (char* filename)
+{
+    benchname = filename;
+    benchframes = true;
+    atexit (M_WriteBench);
+}
+
+
+//
+// M_BenchStartFrame
+//
+void M_BenchStartFrame (void)
+{
+    if (!benchframes)
+	return;
+	
+    memset (&frame, 0, sizeof(frame));
+    laptime = I_GetTimeUS ();
+    inframe = true;
+}
+
+
+//
+// M_BenchLap
+//
+void M_BenchLap (benchphase_e phase)
+{
+    long long	now;
+	
+    if (!inframe)
+	return;
+	
+    now = I_GetTimeUS ();
+    frame.time[phase] += now - laptime;
+    laptime = now;
+}
+
+
+//
+// M_BenchEndFrame
+//
+void M_BenchEndFrame (void)
+{
+    int		i;
+	
+    if (!inframe)
+	return;
+	
+    M_BenchLap (bp_other);
+    inframe = false;
+	
+    for (i=0 ; i<NUMBENCHPHASES ; i++)
+	frame.time[NUMBENCHPHASES] += frame.time[i];
+	
+    if (numframes == maxframes)
+    {
+	maxframes = maxframes ? maxframes*2 : 4096;
+	frames = realloc (frames, maxframes*sizeof(*frames));
+	if (!frames)
+	    I_Error ("M_BenchEndFrame: couldn't grow to %i", maxframes);
+    }
+    frames[numframes++] = frame;
+}
+
+
+//
+// M_BenchPercentile
+// Nearest rank over the sorted times.
+//
+static int
+M_BenchPercentile
+( int		count,
+  int		percent )
+{
+    int		rank;
+	
+    rank = (count*percent + 99)/100 - 1;
+    if (rank < 0)
+	rank = 0;
+    return sorted[rank];
+}
+
+
+static int M_CompareTimes (const void* a, const void* b)
+{
+    return *(int *)a - *(int *)b;
+}
+
+
+//
+// M_BenchSort
+// Sorts one phase of a run of frames into sorted[],
+// returning the mean.
+//
+static double
+M_BenchSort
+( int		first,
+  int		count,
+  int		phase )
+{
+    double	sum;
+    int		i;
+	
+    if (count > maxsorted)
+    {
+	maxsorted = count;
+	sorted = realloc (sorted, maxsorted*sizeof(*sorted));
+	if (!sorted)
+	    I_Error ("M_BenchSort: couldn't grow to %i", maxsorted);
+    }
+	
+    sum = 0;
+    for (i=0 ; i<count ; i++)
+    {
+	sorted[i] = frames[first+i].time[phase];
+	sum += sorted[i];
+    }
+    qsort (sorted, count, sizeof(*sorted), M_CompareTimes);
+	
+    return sum / count;
+}
+
+
+//
+// M_BenchEndDemo
+// Called from the game tic that ends a demo,
+// which closes the frame it is in.
+//
+void M_BenchEndDemo (char* name, int gametics)
+{
+    benchdemo_t*	demo;
+    double		mean;
+	
+    if (!benchframes)
+	return;
+	
+    if (inframe)
+    {
+	M_BenchLap (bp_playsim);
+	M_BenchEndFrame ();
+    }
+	
+    if (numdemos == maxdemos)
+    {
+	maxdemos = maxdemos ? maxdemos*2 : 16;
+	demos = realloc (demos, maxdemos*sizeof(*demos));
+	if (!demos)
+	    I_Error ("M_BenchEndDemo: couldn't grow to %i", maxdemos);
+    }
+    demo = &demos[numdemos++];
+    demo->name = name;
+    demo->gametics = gametics;
+    demo->firstframe = demofirst;
+    demo->numframes = numframes - demofirst;
+    demofirst = numframes;
+	
+    if (!demo->numframes)
+	return;
+	
+    mean = M_BenchSort (demo->firstframe, demo->numframes, NUMBENCHPHASES);
+    printf ("timed %s: %i gametics in %i frames, %.3f s (%.1f fps), "
+	    "p99 %.3f ms\n",
+	    name, gametics, demo->numframes,
+	    mean*demo->numframes/1000000.0,
+	    1000000.0/mean,
+	    M_BenchPercentile (demo->numframes, 99)/1000.0);
+}
+
+
+//
+// M_WriteBenchJSON
+//
+static void
+M_WriteBenchJSON
+( FILE*		f,
+  char*		name,
+  int		gametics,
+  int		first,
+  int		count )
+{
+    double	mean;
+    int		i;
+	
+    fprintf (f, "{\n      \"name\": \"%s\",\n", name);
+    fprintf (f, "      \"gametics\": %i,\n", gametics);
+    fprintf (f, "      \"frames\": %i,\n", count);
+    fprintf (f, "      \"ms\": {\n");
+    for (i=0 ; i<=NUMBENCHPHASES ; i++)
+    {
+	mean = M_BenchSort (first, count, i);
+	fprintf (f, "        \"%s\": { \"mean\": %.3f, \"p50\": %.3f, "
+		 "\"p95\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+		 phasenames[i], mean/1000.0,
+		 M_BenchPercentile (count, 50)/1000.0,
+		 M_BenchPercentile (count, 95)/1000.0,
+		 M_BenchPercentile (count, 99)/1000.0,
+		 sorted[count-1]/1000.0,
+		 i < NUMBENCHPHASES ? "," : "");
+    }
+    fprintf (f, "      }\n    }");
+}
+
+
+//
+// M_WriteBenchCSV
+//
+static void
+M_WriteBenchCSV
+( FILE*		f,
+  char*		name,
+  int		gametics,
+  int		first,
+  int		count )
+{
+    double	mean;
+    int		i;
+	
+    for (i=0 ; i<=NUMBENCHPHASES ; i++)
+    {
+	mean = M_BenchSort (first, count, i);
+	fprintf (f, "%s,%i,%i,%s,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+		 name, gametics, count, phasenames[i], mean/1000.0,
+		 M_BenchPercentile (count, 50)/1000.0,
+		 M_BenchPercentile (count, 95)/1000.0,
+		 M_BenchPercentile (count, 99)/1000.0,
+		 sorted[count-1]/1000.0);
+    }
+}
+
+
+//
+// M_WriteBench
+// Writes CSV if the file name ends in .csv, JSON otherwise.
+// One run per demo, then "all" over every frame.
+// Times are in milliseconds.
+//
+void M_WriteBench (void)
+{
+    FILE*	f;
+    boolean	csv;
+    int		gametics;
+    int		dot;
+    int		i;
+	
+    if (!benchframes)
+	return;
+	
+    // frames of a demo that never finished
+    inframe = false;
+    if (demofirst < numframes)
+	M_BenchEndDemo ("unfinished", 0);
+    benchframes = false;
+    if (!numframes)
+	return;
+	
+    f = fopen (benchname, "w");
+    if (!f)
+    {
+	fprintf (stderr, "M_WriteBench: couldn't write %s\n", benchname);
+	return;
+    }
+	
+    dot = strlen (benchname) - 4;
+    csv = dot >= 0 && !strcmp (benchname+dot, ".csv");
+	
+    gametics = 0;
+    for (i=0 ; i<numdemos ; i++)
+	gametics += demos[i].gametics;
+	
+    if (csv)
+    {
+	fprintf (f, "demo,gametics,frames,phase,mean_ms,p50_ms,p95_ms,"
+		 "p99_ms,max_ms\n");
+	for (i=0 ; i<numdemos ; i++)
+	{
+	    if (demos[i].numframes)
+		M_WriteBenchCSV (f, demos[i].name, demos[i].gametics,
+				 demos[i].firstframe, demos[i].numframes);
+	}
+	M_WriteBenchCSV (f, "all", gametics, 0, numframes);
+    }
+    else
+    {
+	fprintf (f, "{\n  \"runs\": [\n");
+	for (i=0 ; i<numdemos ; i++)
+	{
+	    if (!demos[i].numframes)
+		continue;
+	    fprintf (f, "    ");
+	    M_WriteBenchJSON (f, demos[i].name, demos[i].gametics,
+			      demos[i].firstframe, demos[i].numframes);
+	    fprintf (f, ",\n");
+	}
+	fprintf (f, "    ");
+	M_WriteBenchJSON (f, "all", gametics, 0, numframes);
+	fprintf (f, "\n  ]\n}\n");
+    }
+	
+    fclose (f);
+    printf ("M_WriteBench: wrote %s\n", benchname);
+}
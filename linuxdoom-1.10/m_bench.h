@@ -0,0 +1,71 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// $Id:$
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Timedemo frame timing, split into phases,
+//	written out as JSON or CSV at the end.
+//    
+//-----------------------------------------------------------------------------
+
+
+#ifndef __M_BENCH__
+#define __M_BENCH__
+
+#include "doomtype.h"
+
+//
+// Each frame's wall time is split between these.
+// Time not inside a marked phase goes to bp_other.
+//
+typedef enum
+{
+    bp_playsim,
+    bp_bsp,
+    bp_planes,
+    bp_masked,
+    bp_blit,
+    bp_sound,
+    bp_other,
+    NUMBENCHPHASES
+    
+} benchphase_e;
+
+// True while a -timedemo is being timed.
+extern boolean	benchframes;
+
+// Turns on frame timing, the report is
+// written to filename by M_WriteBench.
+void M_BenchInit (char* filename);
+
+void M_BenchStartFrame (void);
+
+// Charges the time since the last lap to phase.
+void M_BenchLap (benchphase_e phase);
+
+void M_BenchEndFrame (void);
+
+// Closes off the frames of one demo.
+void M_BenchEndDemo (char* name, int gametics);
+
+void M_WriteBench (void);
+
+
+#endif
+//-----------------------------------------------------------------------------
+//
+// $Log:$
+//
+//-----------------------------------------------------------------------------
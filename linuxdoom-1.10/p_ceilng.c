@@ -42,7 +42,7 @@ rcsid[] = "$Id: p_ceilng.c,v 1.4 1997/02/03 16:47:53 b1 Exp $";
 //
 
 
-ceiling_t*	activeceilings[MAXCEILINGS];
+ceiling_t*	activeceilings[ACTIVEHASH];
 
 
 //
@@ -250,16 +250,14 @@ EV_DoCeiling
 //
 void P_AddActiveCeiling(ceiling_t* c)
 {
-    int		i;
-    
-    for (i = 0; i < MAXCEILINGS;i++)
-    {
-	if (activeceilings[i] == NULL)
-	{
-	    activeceilings[i] = c;
-	    return;
-	}
-    }
+    ceiling_t**	head;
+
+    head = &activeceilings[ACTIVEHASHKEY(c->tag)];
+    c->tprev = NULL;
+    c->tnext = *head;
+    if (*head)
+	(*head)->tprev = c;
+    *head = c;
 }
 
 
@@ -269,18 +267,41 @@ void P_AddActiveCeiling(ceiling_t* c)
 //
 void P_RemoveActiveCeiling(ceiling_t* c)
 {
+    ceiling_t**	head;
+	
+    head = &activeceilings[ACTIVEHASHKEY(c->tag)];
+    if (!c->tprev && *head != c)
+	return;
+    
+    if (c->tnext)
+	c->tnext->tprev = c->tprev;
+    if (c->tprev)
+	c->tprev->tnext = c->tnext;
+    else
+	*head = c->tnext;
+    
+    c->sector->specialdata = NULL;
+    P_RemoveThinker (&c->thinker);
+}
+
+
+
+//
+// P_IsActiveCeiling
+// For the savegame, which must tell ceilings
+// in stasis from other stopped thinkers.
+//
+boolean P_IsActiveCeiling(ceiling_t* c)
+{
+    ceiling_t*	check;
     int		i;
 	
-    for (i = 0;i < MAXCEILINGS;i++)
-    {
-	if (activeceilings[i] == c)
-	{
-	    activeceilings[i]->sector->specialdata = NULL;
-	    P_RemoveThinker (&activeceilings[i]->thinker);
-	    activeceilings[i] = NULL;
-	    break;
-	}
-    }
+    for (i = 0;i < ACTIVEHASH;i++)
+	for (check = activeceilings[i] ; check ; check = check->tnext)
+	    if (check == c)
+		return true;
+
+    return false;
 }
 
 
@@ -290,16 +311,15 @@ void P_RemoveActiveCeiling(ceiling_t* c)
 //
 void P_ActivateInStasisCeiling(line_t* line)
 {
-    int		i;
+    ceiling_t*	c;
 	
-    for (i = 0;i < MAXCEILINGS;i++)
+    for (c = activeceilings[ACTIVEHASHKEY(line->tag)] ; c ; c = c->tnext)
     {
-	if (activeceilings[i]
-	    && (activeceilings[i]->tag == line->tag)
-	    && (activeceilings[i]->direction == 0))
+	if (c->tag == line->tag
+	    && c->direction == 0)
 	{
-	    activeceilings[i]->direction = activeceilings[i]->olddirection;
-	    activeceilings[i]->thinker.function.acp1
+	    c->direction = c->olddirection;
+	    c->thinker.function.acp1
 	      = (actionf_p1)T_MoveCeiling;
 	}
     }
@@ -313,19 +333,18 @@ void P_ActivateInStasisCeiling(line_t* line)
 //
 int	EV_CeilingCrushStop(line_t	*line)
 {
-    int		i;
+    ceiling_t*	c;
     int		rtn;
 	
     rtn = 0;
-    for (i = 0;i < MAXCEILINGS;i++)
+    for (c = activeceilings[ACTIVEHASHKEY(line->tag)] ; c ; c = c->tnext)
     {
-	if (activeceilings[i]
-	    && (activeceilings[i]->tag == line->tag)
-	    && (activeceilings[i]->direction != 0))
+	if (c->tag == line->tag
+	    && c->direction != 0)
 	{
-	    activeceilings[i]->olddirection = activeceilings[i]->direction;
-	    activeceilings[i]->thinker.function.acv = (actionf_v)NULL;
-	    activeceilings[i]->direction = 0;		// in-stasis
+	    c->olddirection = c->direction;
+	    c->thinker.function.acv = (actionf_v)NULL;
+	    c->direction = 0;		// in-stasis
 	    rtn = 1;
 	}
     }
@@ -28,6 +28,7 @@ rcsid[] = "$Id: p_enemy.c,v 1.5 1997/02/03 22:45:11 b1 Exp $";
 
 #include <stdlib.h>
 
+#include "m_bbox.h"
 #include "m_random.h"
 #include "i_system.h"
 
@@ -95,56 +96,118 @@ void A_Fall (mobj_t *actor);
 
 
 //
+// P_FloodSound
 // Called by P_NoiseAlert.
-// Recursively traverse adjacent sectors,
-// sound blocking lines cut off traversal.
+// Floods adjacent sectors breadth first,
+//  sound blocking lines cut off traversal
+//  once one has been crossed.
+// Sectors reachable without crossing a blocking line
+//  are flooded first, so each sector ends up with the
+//  fewest blocking lines on any path to it, the same
+//  result the old recursive flood converged to.
 //
 
 mobj_t*		soundtarget;
 
-void
-P_RecursiveSound
-( sector_t*	sec,
-  int		soundblocks )
+static sector_t**	soundqueue;
+static int		soundqueuesize;
+
+static void P_FloodSound (sector_t* start)
 {
+    sector_t**	queue0;		// not blocked
+    sector_t**	queue1;		// behind one blocking line
+    int		head0;
+    int		tail0;
+    int		head1;
+    int		tail1;
     int		i;
-    line_t*	check;
+    sector_t*	sec;
     sector_t*	other;
-	
-    // wake up all monsters in this sector
-    if (sec->validcount == validcount
-	&& sec->soundtraversed <= soundblocks+1)
+    sectoradj_t* adj;
+
+    if (soundqueuesize < numsectors)
     {
-	return;		// already flooded
+	soundqueuesize = numsectors;
+	soundqueue = realloc (soundqueue,
+			      2*soundqueuesize*sizeof(*soundqueue));
+	if (!soundqueue)
+	    I_Error ("P_FloodSound: couldn't allocate queue");
     }
-    
-    sec->validcount = validcount;
-    sec->soundtraversed = soundblocks+1;
-    sec->soundtarget = soundtarget;
-	
-    for (i=0 ;i<sec->linecount ; i++)
+
+    // every sector is queued at most once per level
+    queue0 = soundqueue;
+    queue1 = soundqueue+soundqueuesize;
+    head0 = tail0 = head1 = tail1 = 0;
+
+    start->validcount = validcount;
+    start->soundtraversed = 1;
+    start->soundtarget = soundtarget;
+    queue0[tail0++] = start;
+
+    while (head0 < tail0)
     {
-	check = sec->lines[i];
-	if (! (check->flags & ML_TWOSIDED) )
-	    continue;
+	sec = queue0[head0++];
 	
-	P_LineOpening (check);
+	for (i=0, adj=sec->neighbors ; i<sec->neighborcount ; i++, adj++)
+	{
+	    P_LineOpening (adj->line);
 
-	if (openrange <= 0)
-	    continue;	// closed door
-	
-	if ( sides[ check->sidenum[0] ].sector == sec)
-	    other = sides[ check->sidenum[1] ] .sector;
-	else
-	    other = sides[ check->sidenum[0] ].sector;
+	    if (openrange <= 0)
+		continue;	// closed door
+
+	    other = adj->sector;
+	    if (adj->line->flags & ML_SOUNDBLOCK)
+	    {
+		if (other->validcount == validcount
+		    && other->soundtraversed <= 2)
+		    continue;	// already flooded
+
+		other->validcount = validcount;
+		other->soundtraversed = 2;
+		other->soundtarget = soundtarget;
+		queue1[tail1++] = other;
+	    }
+	    else
+	    {
+		if (other->validcount == validcount
+		    && other->soundtraversed <= 1)
+		    continue;	// already flooded
+
+		other->validcount = validcount;
+		other->soundtraversed = 1;
+		other->soundtarget = soundtarget;
+		queue0[tail0++] = other;
+	    }
+	}
+    }
+
+    while (head1 < tail1)
+    {
+	sec = queue1[head1++];
+	if (sec->soundtraversed != 2)
+	    continue;	// reached unblocked after all
 	
-	if (check->flags & ML_SOUNDBLOCK)
+	for (i=0, adj=sec->neighbors ; i<sec->neighborcount ; i++, adj++)
 	{
-	    if (!soundblocks)
-		P_RecursiveSound (other, 1);
+	    // a second blocking line stops the sound
+	    if (adj->line->flags & ML_SOUNDBLOCK)
+		continue;
+
+	    P_LineOpening (adj->line);
+
+	    if (openrange <= 0)
+		continue;	// closed door
+
+	    other = adj->sector;
+	    if (other->validcount == validcount
+		&& other->soundtraversed <= 2)
+		continue;	// already flooded
+
+	    other->validcount = validcount;
+	    other->soundtraversed = 2;
+	    other->soundtarget = soundtarget;
+	    queue1[tail1++] = other;
 	}
-	else
-	    P_RecursiveSound (other, soundblocks);
     }
 }
 
@@ -162,7 +225,7 @@ P_NoiseAlert
 {
     soundtarget = target;
     validcount++;
-    P_RecursiveSound (emmiter->subsector->sector, 0);
+    P_FloodSound (emmiter->subsector->sector);
 }
 
 
@@ -1176,6 +1239,7 @@ void A_VileChase (mobj_t* actor)
 
     mobjinfo_t*		info;
     mobj_t*		temp;
+    fixed_t		box[4];
 	
     if (actor->movedir != DI_NODIR)
     {
@@ -1190,6 +1254,12 @@ void A_VileChase (mobj_t* actor)
 	yl = (viletryy - bmaporgy - MAXRADIUS*2)>>MAPBLOCKSHIFT;
 	yh = (viletryy - bmaporgy + MAXRADIUS*2)>>MAPBLOCKSHIFT;
 	
+	// corpses touching the vile at the spot
+	box[BOXTOP] = viletryy + mobjinfo[MT_VILE].radius;
+	box[BOXBOTTOM] = viletryy - mobjinfo[MT_VILE].radius;
+	box[BOXRIGHT] = viletryx + mobjinfo[MT_VILE].radius;
+	box[BOXLEFT] = viletryx - mobjinfo[MT_VILE].radius;
+	
 	vileobj = actor;
 	for (bx=xl ; bx<=xh ; bx++)
 	{
@@ -1198,7 +1268,7 @@ void A_VileChase (mobj_t* actor)
 		// Call PIT_VileCheck to check
 		// whether object is a corpse
 		// that canbe raised.
-		if (!P_BlockThingsIterator(bx,by,PIT_VileCheck))
+		if (!P_BlockThingsIteratorBox(bx,by,box,PIT_VileCheck))
 		{
 		    // got one!
 		    temp = actor->target;
@@ -1322,6 +1392,7 @@ void A_VileAttack (mobj_t* actor)
 
     S_StartSound (actor, sfx_barexp);
     P_DamageMobj (actor->target, actor, actor, 20);
+    P_WakeThinker (&actor->target->thinker);
     actor->target->momz = 1000*FRACUNIT/actor->target->info->mass;
 	
     an = actor->angle >> ANGLETOFINESHIFT;
@@ -1810,6 +1881,9 @@ mobj_t*		braintargets[32];
 int		numbraintargets;
 int		braintargeton;
 
+// every other spit is skipped on easy
+int		braineasy;
+
 void A_BrainAwake (mobj_t* mo)
 {
     thinker_t*	thinker;
@@ -1902,11 +1976,9 @@ void A_BrainSpit (mobj_t*	mo)
 {
     mobj_t*	targ;
     mobj_t*	newmobj;
-    
-    static int	easy = 0;
 	
-    easy ^= 1;
-    if (gameskill <= sk_easy && (!easy))
+    braineasy ^= 1;
+    if (gameskill <= sk_easy && (!braineasy))
 	return;
 		
     // shoot a cube at current target
@@ -56,6 +56,9 @@ T_MovePlane
 {
     boolean	flag;
     fixed_t	lastpos;
+
+    // cached sight checks may go through this sector
+    P_ClearSightCache ();
 	
     switch(floorOrCeiling)
     {
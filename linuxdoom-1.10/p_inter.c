@@ -786,6 +786,8 @@ P_DamageMobj
 	
     if ( !(target->flags & MF_SHOOTABLE) )
 	return;	// shouldn't happen...
+
+    P_WakeThinker (&target->thinker);
 		
     if (target->health <= 0)
 	return;
@@ -26,8 +26,11 @@ static const char
 rcsid[] = "$Id: p_lights.c,v 1.5 1997/02/03 22:45:11 b1 Exp $";
 
 
+#include <stdlib.h>
+
 #include "z_zone.h"
 #include "m_random.h"
+#include "i_system.h"
 
 #include "doomdef.h"
 #include "p_local.h"
@@ -75,9 +78,9 @@ void P_SpawnFireFlicker (sector_t*	sector)
 	
     flick = Z_Malloc ( sizeof(*flick), PU_LEVSPEC, 0);
 
+    flick->thinker.function.acp1 = (actionf_p1) T_FireFlicker;
     P_AddThinker (&flick->thinker);
 
-    flick->thinker.function.acp1 = (actionf_p1) T_FireFlicker;
     flick->sector = sector;
     flick->maxlight = sector->lightlevel;
     flick->minlight = P_FindMinSurroundingLight(sector,sector->lightlevel)+16;
@@ -130,9 +133,9 @@ void P_SpawnLightFlash (sector_t*	sector)
 	
     flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
 
+    flash->thinker.function.acp1 = (actionf_p1) T_LightFlash;
     P_AddThinker (&flash->thinker);
 
-    flash->thinker.function.acp1 = (actionf_p1) T_LightFlash;
     flash->sector = sector;
     flash->maxlight = sector->lightlevel;
 
@@ -187,12 +190,12 @@ P_SpawnStrobeFlash
 	
     flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
 
+    flash->thinker.function.acp1 = (actionf_p1) T_StrobeFlash;
     P_AddThinker (&flash->thinker);
 
     flash->sector = sector;
     flash->darktime = fastOrSlow;
     flash->brighttime = STROBEBRIGHT;
-    flash->thinker.function.acp1 = (actionf_p1) T_StrobeFlash;
     flash->maxlight = sector->lightlevel;
     flash->minlight = P_FindMinSurroundingLight(sector, sector->lightlevel);
 		
@@ -240,26 +243,19 @@ void EV_TurnTagLightsOff(line_t* line)
     int			min;
     sector_t*		sector;
     sector_t*		tsec;
-    line_t*		templine;
 	
-    sector = sectors;
-    
-    for (j = 0;j < numsectors; j++, sector++)
+    j = -1;
+    while ((j = P_FindSectorFromLineTag(line,j)) >= 0)
     {
-	if (sector->tag == line->tag)
+	sector = &sectors[j];
+	min = sector->lightlevel;
+	for (i = 0;i < sector->neighborcount; i++)
 	{
-	    min = sector->lightlevel;
-	    for (i = 0;i < sector->linecount; i++)
-	    {
-		templine = sector->lines[i];
-		tsec = getNextSector(templine,sector);
-		if (!tsec)
-		    continue;
-		if (tsec->lightlevel < min)
-		    min = tsec->lightlevel;
-	    }
-	    sector->lightlevel = min;
+	    tsec = sector->neighbors[i].sector;
+	    if (tsec->lightlevel < min)
+		min = tsec->lightlevel;
 	}
+	sector->lightlevel = min;
     }
 }
 
@@ -276,33 +272,26 @@ EV_LightTurnOn
     int		j;
     sector_t*	sector;
     sector_t*	temp;
-    line_t*	templine;
 	
-    sector = sectors;
-	
-    for (i=0;i<numsectors;i++, sector++)
+    i = -1;
+    while ((i = P_FindSectorFromLineTag(line,i)) >= 0)
     {
-	if (sector->tag == line->tag)
+	sector = &sectors[i];
+
+	// bright = 0 means to search
+	// for highest light level
+	// surrounding sector
+	if (!bright)
 	{
-	    // bright = 0 means to search
-	    // for highest light level
-	    // surrounding sector
-	    if (!bright)
+	    for (j = 0;j < sector->neighborcount; j++)
 	    {
-		for (j = 0;j < sector->linecount; j++)
-		{
-		    templine = sector->lines[j];
-		    temp = getNextSector(templine,sector);
+		temp = sector->neighbors[j].sector;
 
-		    if (!temp)
-			continue;
-
-		    if (temp->lightlevel > bright)
-			bright = temp->lightlevel;
-		}
+		if (temp->lightlevel > bright)
+		    bright = temp->lightlevel;
 	    }
-	    sector-> lightlevel = bright;
 	}
+	sector-> lightlevel = bright;
     }
 }
 
@@ -344,14 +333,312 @@ void P_SpawnGlowingLight(sector_t*	sector)
 	
     g = Z_Malloc( sizeof(*g), PU_LEVSPEC, 0);
 
+    g->thinker.function.acp1 = (actionf_p1) T_Glow;
     P_AddThinker(&g->thinker);
 
     g->sector = sector;
     g->minlight = P_FindMinSurroundingLight(sector,sector->lightlevel);
     g->maxlight = sector->lightlevel;
-    g->thinker.function.acp1 = (actionf_p1) T_Glow;
     g->direction = -1;
 
     sector->special = 0;
 }
 
+
+
+//
+// LIGHT BATCHES
+// With -thinkerlists the light thinkers are kept off
+// the main thinker list (see P_RunThinkers) and each
+// type runs as one loop over arrays of its fields.
+// While the batches are built the arrays hold the
+// live state; P_FlushLightBatches copies it back.
+//
+typedef struct
+{
+    int		num;
+    int		max;
+    thinker_t**	thinker;
+    sector_t**	sector;
+    int*	count;		// glow: direction
+    int*	minlight;
+    int*	maxlight;
+    int*	mintime;	// strobe: darktime
+    int*	maxtime;	// strobe: brighttime
+    
+} lightbatch_t;
+
+enum
+{
+    lb_flicker,
+    lb_flash,
+    lb_strobe,
+    lb_glow,
+    NUMLIGHTBATCHES
+};
+
+static lightbatch_t	lightbatches[NUMLIGHTBATCHES];
+static boolean		lightbatchesvalid;
+
+
+//
+// P_IsLightThinker
+//
+boolean P_IsLightThinker (thinker_t* th)
+{
+    return th->function.acp1 == (actionf_p1) T_FireFlicker
+	|| th->function.acp1 == (actionf_p1) T_LightFlash
+	|| th->function.acp1 == (actionf_p1) T_StrobeFlash
+	|| th->function.acp1 == (actionf_p1) T_Glow;
+}
+
+
+//
+// P_AddToLightBatch
+// Returns the slot for one more light.
+//
+static int P_AddToLightBatch (lightbatch_t* b)
+{
+    if (b->num == b->max)
+    {
+	b->max = b->max ? b->max*2 : 64;
+	b->thinker = realloc (b->thinker, b->max*sizeof(*b->thinker));
+	b->sector = realloc (b->sector, b->max*sizeof(*b->sector));
+	b->count = realloc (b->count, b->max*sizeof(*b->count));
+	b->minlight = realloc (b->minlight, b->max*sizeof(*b->minlight));
+	b->maxlight = realloc (b->maxlight, b->max*sizeof(*b->maxlight));
+	b->mintime = realloc (b->mintime, b->max*sizeof(*b->mintime));
+	b->maxtime = realloc (b->maxtime, b->max*sizeof(*b->maxtime));
+
+	if (!b->thinker || !b->sector || !b->count
+	    || !b->minlight || !b->maxlight
+	    || !b->mintime || !b->maxtime)
+	    I_Error ("P_AddToLightBatch: couldn't grow to %i", b->max);
+    }
+    return b->num++;
+}
+
+
+//
+// P_BuildLightBatches
+// Loads every light on the list into the arrays,
+// keeping list order within each type.
+//
+static void P_BuildLightBatches (thinker_t* cap)
+{
+    thinker_t*		th;
+    thinker_t*		next;
+    fireflicker_t*	flick;
+    lightflash_t*	flash;
+    strobe_t*		strobe;
+    glow_t*		glow;
+    lightbatch_t*	b;
+    int			i;
+
+    for (i=0 ; i<NUMLIGHTBATCHES ; i++)
+	lightbatches[i].num = 0;
+    
+    for (th = cap->next ; th != cap ; th = next)
+    {
+	next = th->next;
+	
+	if (th->function.acv == (actionf_v)(-1))
+	{
+	    th->next->prev = th->prev;
+	    th->prev->next = th->next;
+	    Z_Free (th);
+	    continue;
+	}
+	
+	if (th->function.acp1 == (actionf_p1) T_FireFlicker)
+	{
+	    flick = (fireflicker_t *)th;
+	    b = &lightbatches[lb_flicker];
+	    i = P_AddToLightBatch (b);
+	    b->sector[i] = flick->sector;
+	    b->count[i] = flick->count;
+	    b->minlight[i] = flick->minlight;
+	    b->maxlight[i] = flick->maxlight;
+	}
+	else if (th->function.acp1 == (actionf_p1) T_LightFlash)
+	{
+	    flash = (lightflash_t *)th;
+	    b = &lightbatches[lb_flash];
+	    i = P_AddToLightBatch (b);
+	    b->sector[i] = flash->sector;
+	    b->count[i] = flash->count;
+	    b->minlight[i] = flash->minlight;
+	    b->maxlight[i] = flash->maxlight;
+	    b->mintime[i] = flash->mintime;
+	    b->maxtime[i] = flash->maxtime;
+	}
+	else if (th->function.acp1 == (actionf_p1) T_StrobeFlash)
+	{
+	    strobe = (strobe_t *)th;
+	    b = &lightbatches[lb_strobe];
+	    i = P_AddToLightBatch (b);
+	    b->sector[i] = strobe->sector;
+	    b->count[i] = strobe->count;
+	    b->minlight[i] = strobe->minlight;
+	    b->maxlight[i] = strobe->maxlight;
+	    b->mintime[i] = strobe->darktime;
+	    b->maxtime[i] = strobe->brighttime;
+	}
+	else
+	{
+	    glow = (glow_t *)th;
+	    b = &lightbatches[lb_glow];
+	    i = P_AddToLightBatch (b);
+	    b->sector[i] = glow->sector;
+	    b->count[i] = glow->direction;
+	    b->minlight[i] = glow->minlight;
+	    b->maxlight[i] = glow->maxlight;
+	}
+	b->thinker[i] = th;
+    }
+
+    lightbatchesvalid = true;
+}
+
+
+//
+// P_FlushLightBatches
+// Copies the array state back into the thinkers,
+// which must all still be allocated.
+// The batches are rebuilt on the next run.
+//
+void P_FlushLightBatches (void)
+{
+    lightbatch_t*	b;
+    int			i;
+
+    if (!lightbatchesvalid)
+	return;
+
+    b = &lightbatches[lb_flicker];
+    for (i=0 ; i<b->num ; i++)
+	((fireflicker_t *)b->thinker[i])->count = b->count[i];
+
+    b = &lightbatches[lb_flash];
+    for (i=0 ; i<b->num ; i++)
+	((lightflash_t *)b->thinker[i])->count = b->count[i];
+
+    b = &lightbatches[lb_strobe];
+    for (i=0 ; i<b->num ; i++)
+	((strobe_t *)b->thinker[i])->count = b->count[i];
+
+    b = &lightbatches[lb_glow];
+    for (i=0 ; i<b->num ; i++)
+	((glow_t *)b->thinker[i])->direction = b->count[i];
+
+    lightbatchesvalid = false;
+}
+
+
+//
+// P_ClearLightBatches
+// Drops the batches without touching the thinkers,
+// for when they have already been freed.
+//
+void P_ClearLightBatches (void)
+{
+    lightbatchesvalid = false;
+}
+
+
+//
+// P_RunLightBatches
+// Same effect as calling each thinker on the list,
+// run type by type.
+//
+void P_RunLightBatches (thinker_t* cap)
+{
+    lightbatch_t*	b;
+    sector_t*		sec;
+    int			amount;
+    int			i;
+
+    if (!lightbatchesvalid)
+	P_BuildLightBatches (cap);
+
+    // T_FireFlicker
+    b = &lightbatches[lb_flicker];
+    for (i=0 ; i<b->num ; i++)
+    {
+	if (--b->count[i])
+	    continue;
+
+	sec = b->sector[i];
+	amount = (P_Random()&3)*16;
+	if (sec->lightlevel - amount < b->minlight[i])
+	    sec->lightlevel = b->minlight[i];
+	else
+	    sec->lightlevel = b->maxlight[i] - amount;
+	b->count[i] = 4;
+    }
+
+    // T_LightFlash
+    b = &lightbatches[lb_flash];
+    for (i=0 ; i<b->num ; i++)
+    {
+	if (--b->count[i])
+	    continue;
+
+	sec = b->sector[i];
+	if (sec->lightlevel == b->maxlight[i])
+	{
+	    sec->lightlevel = b->minlight[i];
+	    b->count[i] = (P_Random()&b->mintime[i])+1;
+	}
+	else
+	{
+	    sec->lightlevel = b->maxlight[i];
+	    b->count[i] = (P_Random()&b->maxtime[i])+1;
+	}
+    }
+
+    // T_StrobeFlash
+    b = &lightbatches[lb_strobe];
+    for (i=0 ; i<b->num ; i++)
+    {
+	if (--b->count[i])
+	    continue;
+
+	sec = b->sector[i];
+	if (sec->lightlevel == b->minlight[i])
+	{
+	    sec->lightlevel = b->maxlight[i];
+	    b->count[i] = b->maxtime[i];
+	}
+	else
+	{
+	    sec->lightlevel = b->minlight[i];
+	    b->count[i] = b->mintime[i];
+	}
+    }
+
+    // T_Glow
+    b = &lightbatches[lb_glow];
+    for (i=0 ; i<b->num ; i++)
+    {
+	sec = b->sector[i];
+	if (b->count[i] == -1)
+	{
+	    sec->lightlevel -= GLOWSPEED;
+	    if (sec->lightlevel <= b->minlight[i])
+	    {
+		sec->lightlevel += GLOWSPEED;
+		b->count[i] = 1;
+	    }
+	}
+	else if (b->count[i] == 1)
+	{
+	    sec->lightlevel += GLOWSPEED;
+	    if (sec->lightlevel >= b->maxlight[i])
+	    {
+		sec->lightlevel -= GLOWSPEED;
+		b->count[i] = -1;
+	    }
+	}
+    }
+}
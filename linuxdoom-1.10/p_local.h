@@ -41,6 +41,12 @@
 #define MAPBMASK		(MAPBLOCKSIZE-1)
 #define MAPBTOFRAC		(MAPBLOCKSHIFT-FRACBITS)
 
+// each mapblock is split into THINGCELLS x THINGCELLS
+// finer cells for thing collision, see P_BlockThingsIteratorBox
+#define THINGCELLSHIFT	(MAPBLOCKSHIFT-2)
+#define THINGCELLS		4
+#define THINGCELLSIZE	(1<<THINGCELLSHIFT)
+
 
 // player radius for movement checking
 #define PLAYERRADIUS	16*FRACUNIT
@@ -70,9 +76,15 @@
 extern	thinker_t	thinkercap;	
 
 
+// -thinkerlists, see P_RunThinkers
+extern	boolean		thinkerlists;
+
 void P_InitThinkers (void);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
+void P_SetThinkerLists (boolean on);
+void P_SleepThinker (thinker_t* thinker);
+void P_WakeThinker (thinker_t* thinker);
 
 
 //
@@ -151,9 +163,10 @@ typedef struct
     }			d;
 } intercept_t;
 
+// Initial size, the intercept list grows as needed.
 #define MAXINTERCEPTS	128
 
-extern intercept_t	intercepts[MAXINTERCEPTS];
+extern intercept_t*	intercepts;
 extern intercept_t*	intercept_p;
 
 typedef boolean (*traverser_t) (intercept_t *in);
@@ -175,6 +188,13 @@ void 	P_LineOpening (line_t* linedef);
 boolean P_BlockLinesIterator (int x, int y, boolean(*func)(line_t*) );
 boolean P_BlockThingsIterator (int x, int y, boolean(*func)(mobj_t*) );
 
+boolean
+P_BlockThingsIteratorBox
+( int		x,
+  int		y,
+  fixed_t*	box,
+  boolean(*func)(mobj_t*) );
+
 #define PT_ADDLINES		1
 #define PT_ADDTHINGS	2
 #define PT_EARLYOUT		4
@@ -192,6 +212,7 @@ P_PathTraverse
 
 void P_UnsetThingPosition (mobj_t* thing);
 void P_SetThingPosition (mobj_t* thing);
+void P_ClearThingPositions (void);
 
 
 //
@@ -212,6 +233,8 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+void	P_ClearSightCache (void);
+void	P_PrintSightStats (void);
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
@@ -244,13 +267,18 @@ P_RadiusAttack
 // P_SETUP
 //
 extern byte*		rejectmatrix;	// for fast sight rejection
-extern short*		blockmaplump;	// offsets in blockmap are from here
-extern short*		blockmap;
+extern int*		blockmaplump;	// offsets in blockmap are from here
+extern int*		blockmap;
 extern int		bmapwidth;
 extern int		bmapheight;	// in mapblocks
 extern fixed_t		bmaporgx;
 extern fixed_t		bmaporgy;	// origin of block map
 extern mobj_t**		blocklinks;	// for thing chains
+extern mobj_t**		thingcells;	// finer thing chains
+extern fixed_t*		thingcellradius;	// largest radius linked
+extern boolean		sectorlists;	// -sectorlists
+
+void	P_ClearSecNodes (void);
 
 
 
@@ -424,7 +424,7 @@ P_CheckPosition
 
     for (bx=xl ; bx<=xh ; bx++)
 	for (by=yl ; by<=yh ; by++)
-	    if (!P_BlockThingsIterator(bx,by,PIT_CheckThing))
+	    if (!P_BlockThingsIteratorBox(bx,by,tmbbox,PIT_CheckThing))
 		return false;
     
     // check lines
@@ -1217,6 +1217,7 @@ P_RadiusAttack
     int		yh;
     
     fixed_t	dist;
+    fixed_t	box[4];
 	
     dist = (damage+MAXRADIUS)<<FRACBITS;
     yh = (spot->y + dist - bmaporgy)>>MAPBLOCKSHIFT;
@@ -1226,10 +1227,17 @@ P_RadiusAttack
     bombspot = spot;
     bombsource = source;
     bombdamage = damage;
+
+    // only things within damage of the spot,
+    //  plus their radius, can be hurt
+    box[BOXTOP] = spot->y + (damage<<FRACBITS);
+    box[BOXBOTTOM] = spot->y - (damage<<FRACBITS);
+    box[BOXRIGHT] = spot->x + (damage<<FRACBITS);
+    box[BOXLEFT] = spot->x - (damage<<FRACBITS);
 	
     for (y=yl ; y<=yh ; y++)
 	for (x=xl ; x<=xh ; x++)
-	    P_BlockThingsIterator (x, y, PIT_RadiusAttack );
+	    P_BlockThingsIteratorBox (x, y, box, PIT_RadiusAttack );
 }
 
 
@@ -1258,6 +1266,9 @@ boolean PIT_ChangeSector (mobj_t*	thing)
 {
     mobj_t*	mo;
 	
+    // its floor or ceiling may have moved
+    P_WakeThinker (&thing->thinker);
+	
     if (P_ThingHeightClip (thing))
     {
 	// keep checking
@@ -1324,9 +1335,27 @@ P_ChangeSector
 {
     int		x;
     int		y;
+    secnode_t*	node;
 	
     nofit = false;
     crushchange = crunch;
+
+    // Only the things touching the sector. They come
+    // in a different order than from the blockmap,
+    // so demos and netgames keep the original walk.
+    if (sectorlists
+	&& !demoplayback
+	&& !demorecording
+	&& !netgame)
+    {
+	// New things go in at the head. A thing removed
+	// by PIT_ChangeSector leaves its node on the free
+	// list with snext intact, like the bnext walk.
+	for (node = sector->touchthings ; node ; node = node->snext)
+	    PIT_ChangeSector (node->thing);
+
+	return nofit;
+    }
 	
     // re-check heights for all things near the moving sector
     for (x=sector->blockbox[BOXLEFT] ; x<= sector->blockbox[BOXRIGHT] ; x++)
@@ -29,9 +29,12 @@ rcsid[] = "$Id: p_maputl.c,v 1.5 1997/02/03 22:45:11 b1 Exp $";
 
 
 #include <stdlib.h>
+#include <string.h>
 
 
 #include "m_bbox.h"
+#include "i_system.h"
+#include "z_zone.h"
 
 #include "doomdef.h"
 #include "p_local.h"
@@ -337,6 +340,153 @@ void P_LineOpening (line_t* linedef)
 //
 
 
+//
+// SECTOR TOUCHING LISTS
+// With -sectorlists every thing in the blockmap is
+// linked to the sectors its box overlaps, so that
+// P_ChangeSector only sees the things it can move.
+// The nodes are recycled through a free list.
+//
+boolean		sectorlists;
+
+static secnode_t*	freesecnodes;
+static mobj_t*		secthing;
+static fixed_t		secbbox[4];
+
+
+//
+// P_ClearSecNodes
+// The nodes are PU_LEVEL, so the free list
+// must be dropped with the level.
+//
+void P_ClearSecNodes (void)
+{
+    freesecnodes = NULL;
+}
+
+
+//
+// P_AddSecNode
+//
+static void P_AddSecNode (sector_t* sector, mobj_t* thing)
+{
+    secnode_t*	node;
+
+    for (node = thing->touchsectors ; node ; node = node->tnext)
+	if (node->sector == sector)
+	    return;
+
+    if (freesecnodes)
+    {
+	node = freesecnodes;
+	freesecnodes = node->tnext;
+    }
+    else
+	node = Z_Malloc (sizeof(*node), PU_LEVEL, NULL);
+
+    node->sector = sector;
+    node->thing = thing;
+
+    node->tprev = NULL;
+    node->tnext = thing->touchsectors;
+    if (node->tnext)
+	node->tnext->tprev = node;
+    thing->touchsectors = node;
+
+    node->sprev = NULL;
+    node->snext = sector->touchthings;
+    if (node->snext)
+	node->snext->sprev = node;
+    sector->touchthings = node;
+}
+
+
+//
+// PIT_GetSectors
+// Same lines as PIT_CheckLine clips against.
+//
+static boolean PIT_GetSectors (line_t* ld)
+{
+    if (secbbox[BOXRIGHT] <= ld->bbox[BOXLEFT]
+	|| secbbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
+	|| secbbox[BOXTOP] <= ld->bbox[BOXBOTTOM]
+	|| secbbox[BOXBOTTOM] >= ld->bbox[BOXTOP] )
+	return true;
+
+    if (P_BoxOnLineSide (secbbox, ld) != -1)
+	return true;
+
+    P_AddSecNode (ld->frontsector, secthing);
+    if (ld->backsector)
+	P_AddSecNode (ld->backsector, secthing);
+
+    return true;
+}
+
+
+//
+// P_SetSecNodes
+//
+static void P_SetSecNodes (mobj_t* thing)
+{
+    int		xl;
+    int		xh;
+    int		yl;
+    int		yh;
+    int		bx;
+    int		by;
+
+    thing->touchsectors = NULL;
+    secthing = thing;
+    
+    secbbox[BOXTOP] = thing->y + thing->radius;
+    secbbox[BOXBOTTOM] = thing->y - thing->radius;
+    secbbox[BOXRIGHT] = thing->x + thing->radius;
+    secbbox[BOXLEFT] = thing->x - thing->radius;
+
+    validcount++;
+    
+    xl = (secbbox[BOXLEFT] - bmaporgx)>>MAPBLOCKSHIFT;
+    xh = (secbbox[BOXRIGHT] - bmaporgx)>>MAPBLOCKSHIFT;
+    yl = (secbbox[BOXBOTTOM] - bmaporgy)>>MAPBLOCKSHIFT;
+    yh = (secbbox[BOXTOP] - bmaporgy)>>MAPBLOCKSHIFT;
+
+    for (bx=xl ; bx<=xh ; bx++)
+	for (by=yl ; by<=yh ; by++)
+	    P_BlockLinesIterator (bx,by,PIT_GetSectors);
+
+    // the sector it stands in
+    P_AddSecNode (thing->subsector->sector, thing);
+}
+
+
+//
+// P_UnsetSecNodes
+//
+static void P_UnsetSecNodes (mobj_t* thing)
+{
+    secnode_t*	node;
+    secnode_t*	next;
+
+    for (node = thing->touchsectors ; node ; node = next)
+    {
+	next = node->tnext;
+	
+	if (node->snext)
+	    node->snext->sprev = node->sprev;
+	if (node->sprev)
+	    node->sprev->snext = node->snext;
+	else
+	    node->sector->touchthings = node->snext;
+
+	node->tnext = freesecnodes;
+	freesecnodes = node;
+    }
+    thing->touchsectors = NULL;
+}
+
+
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -382,10 +532,30 @@ void P_UnsetThingPosition (mobj_t* thing)
 		blocklinks[blocky*bmapwidth+blockx] = thing->bnext;
 	    }
 	}
+
+	// unlink from thing cell
+	if (thing->cell >= 0)
+	{
+	    if (thing->cnext)
+		thing->cnext->cprev = thing->cprev;
+	
+	    if (thing->cprev)
+		thing->cprev->cnext = thing->cnext;
+	    else
+		thingcells[thing->cell] = thing->cnext;
+	}
+
+	if (sectorlists)
+	    P_UnsetSecNodes (thing);
     }
 }
 
 
+// Orders the things by the time they were linked.
+// Every thing list is in that order, newest first.
+static long long	linkstamp;
+
+
 //
 // P_SetThingPosition
 // Links a thing into both a block and a subsector
@@ -399,12 +569,15 @@ P_SetThingPosition (mobj_t* thing)
     sector_t*		sec;
     int			blockx;
     int			blocky;
+    int			cell;
+    fixed_t		radius;
     mobj_t**		link;
 
     
     // link into subsector
     ss = R_PointInSubsector (thing->x,thing->y);
     thing->subsector = ss;
+    thing->linkstamp = ++linkstamp;
     
     if ( ! (thing->flags & MF_NOSECTOR) )
     {
@@ -440,12 +613,67 @@ P_SetThingPosition (mobj_t* thing)
 		(*link)->bprev = thing;
 
 	    *link = thing;
+
+	    // link into the cell within the block
+	    cell = (blocky*bmapwidth+blockx)*THINGCELLS*THINGCELLS
+		+ (((thing->y - bmaporgy)>>THINGCELLSHIFT)&(THINGCELLS-1))*THINGCELLS
+		+ (((thing->x - bmaporgx)>>THINGCELLSHIFT)&(THINGCELLS-1));
+	    link = &thingcells[cell];
+	    thing->cell = cell;
+	    thing->cprev = NULL;
+	    thing->cnext = *link;
+	    if (*link)
+		(*link)->cprev = thing;
+
+	    *link = thing;
+
+	    radius = thing->radius > thing->info->radius ?
+		thing->radius : thing->info->radius;
+	    if (thingcellradius[cell] < radius)
+		thingcellradius[cell] = radius;
 	}
 	else
 	{
 	    // thing is off the map
 	    thing->bnext = thing->bprev = NULL;
+	    thing->cell = -1;
+	}
+
+	if (sectorlists)
+	    P_SetSecNodes (thing);
+    }
+}
+
+
+
+//
+// P_ClearThingPositions
+// Empties every thing list at once,
+// for when all the things are freed.
+// Setting them again in linkstamp order
+// gives back the same lists.
+//
+void P_ClearThingPositions (void)
+{
+    int		i;
+    secnode_t*	node;
+    secnode_t*	next;
+
+    memset (blocklinks, 0, bmapwidth*bmapheight*sizeof(*blocklinks));
+    memset (thingcells, 0, bmapwidth*bmapheight*THINGCELLS*THINGCELLS
+	    *sizeof(*thingcells));
+    
+    for (i=0 ; i<numsectors ; i++)
+    {
+	sectors[i].thinglist = NULL;
+	
+	for (node = sectors[i].touchthings ; node ; node = next)
+	{
+	    next = node->snext;
+	    node->tnext = freesecnodes;
+	    freesecnodes = node;
 	}
+	sectors[i].touchthings = NULL;
     }
 }
 
@@ -475,7 +703,7 @@ P_BlockLinesIterator
   boolean(*func)(line_t*) )
 {
     int			offset;
-    short*		list;
+    int*		list;
     line_t*		ld;
 	
     if (x<0
@@ -538,11 +766,125 @@ P_BlockThingsIterator
 
 
 
+//
+// P_BlockThingsIteratorBox
+// Same as P_BlockThingsIterator, but skips the things
+// whose origin is further outside box than their
+// radius, using the thing cells. The rest are
+// visited in blocklinks order, so this matches
+// the full iterator for any func that returns true,
+// and does nothing else, for those things.
+//
+boolean
+P_BlockThingsIteratorBox
+( int			x,
+  int			y,
+  fixed_t*		box,
+  boolean(*func)(mobj_t*) )
+{
+    mobj_t*		heads[THINGCELLS*THINGCELLS];
+    mobj_t*		mobj;
+    int			numheads;
+    int			numcells;
+    int			cell;
+    int			cx;
+    int			cy;
+    int			best;
+    int			i;
+    fixed_t		left;
+    fixed_t		bottom;
+    fixed_t		radius;
+	
+    if ( x<0
+	 || y<0
+	 || x>=bmapwidth
+	 || y>=bmapheight)
+    {
+	return true;
+    }
+
+    numheads = numcells = 0;
+    cell = (y*bmapwidth+x)*THINGCELLS*THINGCELLS;
+    
+    for (cy=0 ; cy<THINGCELLS ; cy++)
+    {
+	bottom = bmaporgy + (y<<MAPBLOCKSHIFT) + (cy<<THINGCELLSHIFT);
+	
+	for (cx=0 ; cx<THINGCELLS ; cx++, cell++)
+	{
+	    if (!thingcells[cell])
+		continue;
+	    numcells++;
+	    
+	    left = bmaporgx + (x<<MAPBLOCKSHIFT) + (cx<<THINGCELLSHIFT);
+	    radius = thingcellradius[cell];
+	    
+	    if (left > box[BOXRIGHT] + radius
+		|| left + THINGCELLSIZE <= box[BOXLEFT] - radius
+		|| bottom > box[BOXTOP] + radius
+		|| bottom + THINGCELLSIZE <= box[BOXBOTTOM] - radius)
+		continue;
+	    
+	    heads[numheads++] = thingcells[cell];
+	}
+    }
+
+    // every occupied cell is in range
+    if (numheads == numcells)
+	return P_BlockThingsIterator (x, y, func);
+
+    // merge the cells back into link order, newest first
+    while (numheads)
+    {
+	best = 0;
+	for (i=1 ; i<numheads ; i++)
+	    if (heads[i]->linkstamp > heads[best]->linkstamp)
+		best = i;
+
+	mobj = heads[best];
+	if (!func (mobj) )
+	    return false;
+	
+	heads[best] = mobj->cnext;
+	if (!heads[best])
+	    heads[best] = heads[--numheads];
+    }
+    return true;
+}
+
+
+
 //
 // INTERCEPT ROUTINES
 //
-intercept_t	intercepts[MAXINTERCEPTS];
+intercept_t*	intercepts;
 intercept_t*	intercept_p;
+static int	numintercepts;	// allocated
+
+// merge buffer for P_TraverseIntercepts
+static intercept_t*	sortintercepts;
+
+
+//
+// P_CheckIntercepts
+// Makes room for one more intercept.
+//
+static void P_CheckIntercepts (void)
+{
+    int		count;
+
+    count = intercept_p - intercepts;
+    if (count < numintercepts)
+	return;
+
+    numintercepts = numintercepts ? numintercepts*2 : MAXINTERCEPTS;
+    intercepts = realloc (intercepts, numintercepts*sizeof(*intercepts));
+    sortintercepts = realloc (sortintercepts,
+			      numintercepts*sizeof(*sortintercepts));
+    if (!intercepts || !sortintercepts)
+	I_Error ("P_CheckIntercepts: couldn't grow to %i", numintercepts);
+    intercept_p = intercepts + count;
+}
 
 divline_t 	trace;
 boolean 	earlyout;
@@ -600,6 +942,7 @@ PIT_AddLineIntercepts (line_t* ld)
     }
     
 	
+    P_CheckIntercepts ();
     intercept_p->frac = frac;
     intercept_p->isaline = true;
     intercept_p->d.line = ld;
@@ -665,6 +1008,7 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     if (frac < 0)
 	return true;		// behind source
 
+    P_CheckIntercepts ();
     intercept_p->frac = frac;
     intercept_p->isaline = false;
     intercept_p->d.thing = thing;
@@ -674,6 +1018,72 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
 }
 
 
+//
+// P_SortIntercepts
+// Stable sort on frac, so intercepts at the same distance
+//  keep the order they were added in. That is the order
+//  the original nearest-first rescan visited them.
+// Insertion sort for the usual handful, merge sort
+//  for long traces.
+//
+static void P_SortIntercepts (void)
+{
+    int			count;
+    int			width;
+    int			i;
+    int			lo;
+    int			mid;
+    int			hi;
+    int			l;
+    int			r;
+    intercept_t*	src;
+    intercept_t*	dst;
+    intercept_t*	swap;
+    intercept_t		in;
+
+    count = intercept_p - intercepts;
+
+    if (count <= 16)
+    {
+	for (i=1 ; i<count ; i++)
+	{
+	    in = intercepts[i];
+	    for (l=i ; l>0 && intercepts[l-1].frac > in.frac ; l--)
+		intercepts[l] = intercepts[l-1];
+	    intercepts[l] = in;
+	}
+	return;
+    }
+
+    src = intercepts;
+    dst = sortintercepts;
+    for (width=1 ; width<count ; width*=2)
+    {
+	for (lo=0 ; lo<count ; lo+=2*width)
+	{
+	    mid = lo+width < count ? lo+width : count;
+	    hi = lo+2*width < count ? lo+2*width : count;
+	    l = lo;
+	    r = mid;
+	    for (i=lo ; i<hi ; i++)
+	    {
+		// take from the left on ties
+		if (l < mid && (r >= hi || src[l].frac <= src[r].frac))
+		    dst[i] = src[l++];
+		else
+		    dst[i] = src[r++];
+	    }
+	}
+	swap = src;
+	src = dst;
+	dst = swap;
+    }
+
+    if (src != intercepts)
+	memcpy (intercepts, src, count*sizeof(*intercepts));
+}
+
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
@@ -684,46 +1094,17 @@ P_TraverseIntercepts
 ( traverser_t	func,
   fixed_t	maxfrac )
 {
-    int			count;
-    fixed_t		dist;
-    intercept_t*	scan;
     intercept_t*	in;
 	
-    count = intercept_p - intercepts;
-    
-    in = 0;			// shut up compiler warning
-	
-    while (count--)
-    {
-	dist = MAXINT;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
-	{
-	    if (scan->frac < dist)
-	    {
-		dist = scan->frac;
-		in = scan;
-	    }
-	}
-	
-	if (dist > maxfrac)
-	    return true;	// checked everything in range		
+    P_SortIntercepts ();
 
-#if 0  // UNUSED
+    for (in = intercepts ; in<intercept_p ; in++)
     {
-	// don't check these yet, there may be others inserted
-	in = scan = intercepts;
-	for ( scan = intercepts ; scan<intercept_p ; scan++)
-	    if (scan->frac > maxfrac)
-		*in++ = *scan;
-	intercept_p = in;
-	return false;
-    }
-#endif
+	if (in->frac > maxfrac)
+	    return true;	// checked everything in range		
 
         if ( !func (in) )
 	    return false;	// don't bother going farther
-
-	in->frac = MAXINT;
     }
 	
     return true;		// everything was traversed
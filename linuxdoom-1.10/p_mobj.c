@@ -57,6 +57,8 @@ P_SetMobjState
 {
     state_t*	st;
 
+    P_WakeThinker (&mobj->thinker);
+	
     do
     {
 	if (state == S_NULL)
@@ -449,6 +451,22 @@ void P_MobjThinker (mobj_t* mobj)
     }
     else
     {
+	// Nothing will happen here until something
+	// moves, hits or changes it; those all wake
+	// the mobj up again (P_SetMobjState,
+	// P_DamageMobj, PIT_ChangeSector, ...).
+	if (!mobj->momx
+	    && !mobj->momy
+	    && !mobj->momz
+	    && mobj->z == mobj->floorz
+	    && !(mobj->flags & MF_SKULLFLY)
+	    && !mobj->player
+	    && (!(mobj->flags & MF_COUNTKILL) || !respawnmonsters))
+	{
+	    P_SleepThinker (&mobj->thinker);
+	    return;
+	}
+	
 	// check for nightmare respawn
 	if (! (mobj->flags & MF_COUNTKILL) )
 	    return;
@@ -530,6 +548,9 @@ P_SpawnMobj
 	
     P_AddThinker (&mobj->thinker);
 
+    if (type == MT_TELEPORTMAN)
+	P_ClearTeleportDests ();
+
     return mobj;
 }
 
@@ -545,6 +566,9 @@ int		iquetail;
 
 void P_RemoveMobj (mobj_t* mobj)
 {
+    if (mobj->type == MT_TELEPORTMAN)
+	P_ClearTeleportDests ();
+
     if ((mobj->flags & MF_SPECIAL)
 	&& !(mobj->flags & MF_DROPPED)
 	&& (mobj->type != MT_INV)
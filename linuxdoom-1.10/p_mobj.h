@@ -227,6 +227,17 @@ typedef struct mobj_s
     // Links in blocks (if needed).
     struct mobj_s*	bnext;
     struct mobj_s*	bprev;
+
+    // Links in the finer thing cells, with the
+    // order things entered their block.
+    struct mobj_s*	cnext;
+    struct mobj_s*	cprev;
+    int			cell;
+    long long		linkstamp;
+
+    // Sectors whose lines the thing overlaps,
+    // with -sectorlists, see P_SetThingPosition.
+    struct secnode_s*	touchsectors;
     
     struct subsector_s*	subsector;
 
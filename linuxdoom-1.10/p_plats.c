@@ -42,7 +42,7 @@ rcsid[] = "$Id: p_plats.c,v 1.5 1997/02/03 22:45:12 b1 Exp $";
 #include "sounds.h"
 
 
-plat_t*		activeplats[MAXPLATS];
+plat_t*		activeplats[ACTIVEHASH];
 
 
 
@@ -257,58 +257,77 @@ EV_DoPlat
 
 void P_ActivateInStasis(int tag)
 {
-    int		i;
+    plat_t*	plat;
 	
-    for (i = 0;i < MAXPLATS;i++)
-	if (activeplats[i]
-	    && (activeplats[i])->tag == tag
-	    && (activeplats[i])->status == in_stasis)
+    for (plat = activeplats[ACTIVEHASHKEY(tag)] ; plat ; plat = plat->tnext)
+	if (plat->tag == tag
+	    && plat->status == in_stasis)
 	{
-	    (activeplats[i])->status = (activeplats[i])->oldstatus;
-	    (activeplats[i])->thinker.function.acp1
+	    plat->status = plat->oldstatus;
+	    plat->thinker.function.acp1
 	      = (actionf_p1) T_PlatRaise;
 	}
 }
 
 void EV_StopPlat(line_t* line)
 {
-    int		j;
+    plat_t*	plat;
 	
-    for (j = 0;j < MAXPLATS;j++)
-	if (activeplats[j]
-	    && ((activeplats[j])->status != in_stasis)
-	    && ((activeplats[j])->tag == line->tag))
+    for (plat = activeplats[ACTIVEHASHKEY(line->tag)] ; plat ; plat = plat->tnext)
+	if (plat->status != in_stasis
+	    && plat->tag == line->tag)
 	{
-	    (activeplats[j])->oldstatus = (activeplats[j])->status;
-	    (activeplats[j])->status = in_stasis;
-	    (activeplats[j])->thinker.function.acv = (actionf_v)NULL;
+	    plat->oldstatus = plat->status;
+	    plat->status = in_stasis;
+	    plat->thinker.function.acv = (actionf_v)NULL;
 	}
 }
 
 void P_AddActivePlat(plat_t* plat)
 {
-    int		i;
-    
-    for (i = 0;i < MAXPLATS;i++)
-	if (activeplats[i] == NULL)
-	{
-	    activeplats[i] = plat;
-	    return;
-	}
-    I_Error ("P_AddActivePlat: no more plats!");
+    plat_t**	head;
+
+    head = &activeplats[ACTIVEHASHKEY(plat->tag)];
+    plat->tprev = NULL;
+    plat->tnext = *head;
+    if (*head)
+	(*head)->tprev = plat;
+    *head = plat;
 }
 
 void P_RemoveActivePlat(plat_t* plat)
 {
+    plat_t**	head;
+
+    head = &activeplats[ACTIVEHASHKEY(plat->tag)];
+    if (!plat->tprev && *head != plat)
+	I_Error ("P_RemoveActivePlat: can't find plat!");
+    
+    if (plat->tnext)
+	plat->tnext->tprev = plat->tprev;
+    if (plat->tprev)
+	plat->tprev->tnext = plat->tnext;
+    else
+	*head = plat->tnext;
+    
+    plat->sector->specialdata = NULL;
+    P_RemoveThinker(&plat->thinker);
+}
+
+//
+// P_IsActivePlat
+// For savestates, which must tell plats
+// in stasis from other stopped thinkers.
+//
+boolean P_IsActivePlat(plat_t* plat)
+{
+    plat_t*	check;
     int		i;
-    for (i = 0;i < MAXPLATS;i++)
-	if (plat == activeplats[i])
-	{
-	    (activeplats[i])->sector->specialdata = NULL;
-	    P_RemoveThinker(&(activeplats[i])->thinker);
-	    activeplats[i] = NULL;
-	    
-	    return;
-	}
-    I_Error ("P_RemoveActivePlat: can't find plat!");
+	
+    for (i = 0;i < ACTIVEHASH;i++)
+	for (check = activeplats[i] ; check ; check = check->tnext)
+	    if (check == plat)
+		return true;
+
+    return false;
 }
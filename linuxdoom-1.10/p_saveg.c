@@ -24,10 +24,13 @@
 static const char
 rcsid[] = "$Id: p_tick.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
+#include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "i_system.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "s_sound.h"
 
 // State.
 #include "doomstat.h"
@@ -272,6 +275,7 @@ void P_UnArchiveThinkers (void)
     mobj_t*		mobj;
     
     // remove all the current thinkers
+    P_SetThinkerLists (false);
     currentthinker = thinkercap.next;
     while (currentthinker != &thinkercap)
     {
@@ -307,8 +311,9 @@ void P_UnArchiveThinkers (void)
 		mobj->player = &players[(int)mobj->player-1];
 		mobj->player->mo = mobj;
 	    }
-	    P_SetThingPosition (mobj);
+	    // the cell radius comes from info
 	    mobj->info = &mobjinfo[mobj->type];
+	    P_SetThingPosition (mobj);
 	    mobj->floorz = mobj->subsector->sector->floorheight;
 	    mobj->ceilingz = mobj->subsector->sector->ceilingheight;
 	    mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
@@ -363,18 +368,16 @@ void P_ArchiveSpecials (void)
     lightflash_t*	flash;
     strobe_t*		strobe;
     glow_t*		glow;
-    int			i;
 	
+    // lights may be batched on their own list
+    P_SetThinkerLists (false);
+
     // save off the current thinkers
     for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
     {
 	if (th->function.acv == (actionf_v)NULL)
 	{
-	    for (i = 0; i < MAXCEILINGS;i++)
-		if (activeceilings[i] == (ceiling_t *)th)
-		    break;
-	    
-	    if (i<MAXCEILINGS)
+	    if (P_IsActiveCeiling ((ceiling_t *)th))
 	    {
 		*save_p++ = tc_ceiling;
 		PADSAVEP();
@@ -585,3 +588,606 @@ void P_UnArchiveSpecials (void)
 
 }
 
+
+
+
+//
+// SAVESTATES
+// Snapshots of the whole playsim, kept in memory
+// to go back to an earlier tic of the same level.
+// Unlike a savegame every live thinker is kept, in
+// run order, with the mobjs it points to, and so are
+// the random index and the other level globals, so a
+// restored game plays on just as the original did.
+// Pointers to thinkers are stored as their numbers,
+// counting from 1. Thinkers already removed are left
+// out, and pointers to them come back NULL.
+//
+enum
+{
+    ts_none,
+    ts_mobj,
+    ts_ceiling,
+    ts_door,
+    ts_floor,
+    ts_plat,
+    ts_fireflicker,
+    ts_flash,
+    ts_strobe,
+    ts_glow,
+    NUMSTATECLASSES
+
+} stateclass_e;
+
+static int statesizes[NUMSTATECLASSES] =
+{
+    0,
+    sizeof(mobj_t),
+    sizeof(ceiling_t),
+    sizeof(vldoor_t),
+    sizeof(floormove_t),
+    sizeof(plat_t),
+    sizeof(fireflicker_t),
+    sizeof(lightflash_t),
+    sizeof(strobe_t),
+    sizeof(glow_t)
+};
+
+// where the sector pointer is, 0 for none
+static int statesectors[NUMSTATECLASSES] =
+{
+    0,
+    0,
+    offsetof(ceiling_t,sector),
+    offsetof(vldoor_t,sector),
+    offsetof(floormove_t,sector),
+    offsetof(plat_t,sector),
+    offsetof(fireflicker_t,sector),
+    offsetof(lightflash_t,sector),
+    offsetof(strobe_t,sector),
+    offsetof(glow_t,sector)
+};
+
+// The saved thinkers, by number.
+static thinker_t**	statethinkers;
+static int		numstatethinkers;
+static int		maxstatethinkers;
+
+// Blocks of the thinkers being replaced, by class,
+// chained through next so a restore can reuse them.
+static thinker_t*	statespare[NUMSTATECLASSES];
+
+extern mobj_t*		braintargets[32];
+extern int		numbraintargets;
+extern int		braintargeton;
+extern int		braineasy;
+
+extern boolean		levelTimer;
+extern int		levelTimeCount;
+
+extern int		prndindex;
+
+
+//
+// P_StateClass
+//
+static int P_StateClass (thinker_t* th)
+{
+    if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	return ts_mobj;
+
+    if (th->function.acv == (actionf_v)NULL)
+    {
+	// movers in stasis
+	if (P_IsActiveCeiling ((ceiling_t *)th))
+	    return ts_ceiling;
+	if (P_IsActivePlat ((plat_t *)th))
+	    return ts_plat;
+	return ts_none;
+    }
+    
+    if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
+	return ts_ceiling;
+    if (th->function.acp1 == (actionf_p1)T_VerticalDoor)
+	return ts_door;
+    if (th->function.acp1 == (actionf_p1)T_MoveFloor)
+	return ts_floor;
+    if (th->function.acp1 == (actionf_p1)T_PlatRaise)
+	return ts_plat;
+    if (th->function.acp1 == (actionf_p1)T_FireFlicker)
+	return ts_fireflicker;
+    if (th->function.acp1 == (actionf_p1)T_LightFlash)
+	return ts_flash;
+    if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
+	return ts_strobe;
+    if (th->function.acp1 == (actionf_p1)T_Glow)
+	return ts_glow;
+
+    // removed
+    return ts_none;
+}
+
+
+//
+// P_GrowStateThinkers
+//
+static void P_GrowStateThinkers (int count)
+{
+    if (count <= maxstatethinkers)
+	return;
+
+    if (!maxstatethinkers)
+	maxstatethinkers = 1024;
+    while (maxstatethinkers < count)
+	maxstatethinkers *= 2;
+	
+    statethinkers = realloc (statethinkers,
+			     maxstatethinkers*sizeof(*statethinkers));
+    if (!statethinkers)
+	I_Error ("P_GrowStateThinkers: couldn't grow to %i",
+		 maxstatethinkers);
+}
+
+
+//
+// P_ThinkerNum
+// While saving, the prev link of each saved
+// thinker holds its number instead.
+// A pointer that is not to one of them,
+// like one to a freed mobj, gives 0.
+//
+static int P_ThinkerNum (void* ptr)
+{
+    thinker_t*	th;
+    int		num;
+
+    th = ptr;
+    if (!th)
+	return 0;
+    
+    num = (intptr_t)th->prev;
+    if (num < 1
+	|| num > numstatethinkers
+	|| statethinkers[num-1] != th)
+	return 0;
+
+    return num;
+}
+
+
+//
+// P_ThinkerPtr
+//
+static void* P_ThinkerPtr (int num)
+{
+    if (num < 1 || num > numstatethinkers)
+	return NULL;
+
+    return statethinkers[num-1];
+}
+
+
+//
+// P_WriteInt / P_ReadInt
+// The state buffer needs no alignment.
+//
+static void P_WriteInt (int value)
+{
+    memcpy (save_p, &value, sizeof(value));
+    save_p += sizeof(value);
+}
+
+static int P_ReadInt (void)
+{
+    int		value;
+	
+    memcpy (&value, save_p, sizeof(value));
+    save_p += sizeof(value);
+    return value;
+}
+
+
+//
+// P_CompareLinkStamps
+//
+static int P_CompareLinkStamps (const void* a, const void* b)
+{
+    mobj_t*	ma;
+    mobj_t*	mb;
+
+    ma = *(mobj_t **)a;
+    mb = *(mobj_t **)b;
+    if (ma->linkstamp < mb->linkstamp)
+	return -1;
+    return ma->linkstamp > mb->linkstamp;
+}
+
+
+
+//
+// P_StateSize
+// At least as much as P_ArchiveState writes.
+//
+int P_StateSize (void)
+{
+    thinker_t*	th;
+    int		size;
+	
+    // lights may be batched on their own list
+    P_SetThinkerLists (false);
+
+    size = 32*sizeof(int)
+	+ MAXPLAYERS*sizeof(player_t)
+	+ numsectors*10*sizeof(int)
+	+ numlines*3*sizeof(int)
+	+ numsides*5*sizeof(int)
+	+ BODYQUESIZE*sizeof(int)
+	+ 32*sizeof(int)
+	+ sizeof(itemrespawnque)
+	+ sizeof(itemrespawntime)
+	+ numbuttons*4*sizeof(int);
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+	size += sizeof(int) + sizeof(mobj_t);
+
+    return size;
+}
+
+
+
+//
+// P_ArchiveState
+//
+void P_ArchiveState (void)
+{
+    thinker_t*	th;
+    int		i;
+    int		j;
+    int		tclass;
+    mobj_t*	mobj;
+    player_t*	player;
+    sector_t*	sec;
+    line_t*	li;
+    side_t*	si;
+    sector_t**	sector;
+	
+    P_SetThinkerLists (false);
+
+    // number the thinkers
+    numstatethinkers = 0;
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	if (P_StateClass (th) == ts_none)
+	    continue;
+	
+	P_GrowStateThinkers (numstatethinkers+1);
+	statethinkers[numstatethinkers++] = th;
+	th->prev = (thinker_t *)(intptr_t)numstatethinkers;
+    }
+
+    P_WriteInt (leveltime);
+    P_WriteInt (rndindex);
+    P_WriteInt (prndindex);
+    P_WriteInt (totalkills);
+    P_WriteInt (totalitems);
+    P_WriteInt (totalsecret);
+    P_WriteInt (levelTimer);
+    P_WriteInt (levelTimeCount);
+
+    // thinkers, with the dormant ones
+    // still having a NULL runprev
+    P_WriteInt (numstatethinkers);
+    for (i=0 ; i<numstatethinkers ; i++)
+    {
+	th = statethinkers[i];
+	tclass = P_StateClass (th);
+	P_WriteInt (tclass);
+	memcpy (save_p, th, statesizes[tclass]);
+	
+	if (tclass == ts_mobj)
+	{
+	    mobj = (mobj_t *)save_p;
+	    mobj->target = (mobj_t *)(intptr_t)P_ThinkerNum (mobj->target);
+	    mobj->tracer = (mobj_t *)(intptr_t)P_ThinkerNum (mobj->tracer);
+	}
+	else
+	{
+	    sector = (sector_t **)(save_p + statesectors[tclass]);
+	    *sector = (sector_t *)(*sector - sectors);
+	}
+	save_p += statesizes[tclass];
+    }
+    
+    // players
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	player = (player_t *)save_p;
+	memcpy (player, &players[i], sizeof(player_t));
+	player->mo = (mobj_t *)(intptr_t)P_ThinkerNum (player->mo);
+	player->attacker =
+	    (mobj_t *)(intptr_t)P_ThinkerNum (player->attacker);
+	save_p += sizeof(player_t);
+    }
+
+    // world
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	P_WriteInt (sec->floorheight);
+	P_WriteInt (sec->ceilingheight);
+	P_WriteInt (sec->floorpic);
+	P_WriteInt (sec->ceilingpic);
+	P_WriteInt (sec->lightlevel);
+	P_WriteInt (sec->special);
+	P_WriteInt (sec->tag);
+	P_WriteInt (sec->soundtraversed);
+	P_WriteInt (P_ThinkerNum (sec->soundtarget));
+	P_WriteInt (P_ThinkerNum (sec->specialdata));
+    }
+    
+    for (i=0, li = lines ; i<numlines ; i++,li++)
+    {
+	P_WriteInt (li->flags);
+	P_WriteInt (li->special);
+	P_WriteInt (li->tag);
+    }
+
+    for (i=0, si = sides ; i<numsides ; i++,si++)
+    {
+	P_WriteInt (si->textureoffset);
+	P_WriteInt (si->rowoffset);
+	P_WriteInt (si->toptexture);
+	P_WriteInt (si->bottomtexture);
+	P_WriteInt (si->midtexture);
+    }
+
+    // queues
+    P_WriteInt (bodyqueslot);
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	P_WriteInt (P_ThinkerNum (bodyque[i]));
+
+    P_WriteInt (numbraintargets);
+    P_WriteInt (braintargeton);
+    P_WriteInt (braineasy);
+    for (i=0 ; i<numbraintargets ; i++)
+	P_WriteInt (P_ThinkerNum (braintargets[i]));
+
+    P_WriteInt (iquehead);
+    P_WriteInt (iquetail);
+    memcpy (save_p, itemrespawnque, sizeof(itemrespawnque));
+    save_p += sizeof(itemrespawnque);
+    memcpy (save_p, itemrespawntime, sizeof(itemrespawntime));
+    save_p += sizeof(itemrespawntime);
+
+    // buttons that are still down
+    for (i=j=0 ; i<numbuttons ; i++)
+	if (buttonlist[i].btimer)
+	    j++;
+    P_WriteInt (j);
+    for (i=0 ; i<numbuttons ; i++)
+    {
+	if (!buttonlist[i].btimer)
+	    continue;
+	P_WriteInt (buttonlist[i].line - lines);
+	P_WriteInt (buttonlist[i].where);
+	P_WriteInt (buttonlist[i].btexture);
+	P_WriteInt (buttonlist[i].btimer);
+    }
+
+    // put the prev links back
+    for (th = &thinkercap ; th->next != &thinkercap ; th = th->next)
+	th->next->prev = th;
+    thinkercap.prev = th;
+}
+
+
+
+//
+// P_UnArchiveState
+// Frees the current thinkers, so the state
+// must be from the level that is loaded.
+//
+void P_UnArchiveState (void)
+{
+    thinker_t*	th;
+    thinker_t*	next;
+    int		i;
+    int		count;
+    int		tclass;
+    int		where;
+    int		texture;
+    boolean	dormant;
+    mobj_t*	mobj;
+    player_t*	player;
+    sector_t*	sec;
+    line_t*	li;
+    side_t*	si;
+    sector_t**	sector;
+	
+    // take the current thinkers off the level,
+    // keeping their blocks to be filled again
+    P_SetThinkerLists (false);
+    P_ClearThingPositions ();
+    
+    for (th = thinkercap.next ; th != &thinkercap ; th = next)
+    {
+	next = th->next;
+	tclass = P_StateClass (th);
+	if (tclass == ts_none)
+	{
+	    Z_Free (th);
+	    continue;
+	}
+	if (tclass == ts_mobj)
+	    S_StopSound ((mobj_t *)th);
+	th->next = statespare[tclass];
+	statespare[tclass] = th;
+    }
+    P_InitThinkers ();
+
+    for (i = 0;i < ACTIVEHASH;i++)
+    {
+	activeceilings[i] = NULL;
+	activeplats[i] = NULL;
+    }
+
+    leveltime = P_ReadInt ();
+    rndindex = P_ReadInt ();
+    prndindex = P_ReadInt ();
+    totalkills = P_ReadInt ();
+    totalitems = P_ReadInt ();
+    totalsecret = P_ReadInt ();
+    levelTimer = P_ReadInt ();
+    levelTimeCount = P_ReadInt ();
+
+    // thinkers
+    count = P_ReadInt ();
+    P_GrowStateThinkers (count);
+    for (i=0 ; i<count ; i++)
+    {
+	tclass = P_ReadInt ();
+	if (tclass <= ts_none || tclass >= NUMSTATECLASSES)
+	    I_Error ("P_UnArchiveState: Unknown tclass %i", tclass);
+	
+	th = statespare[tclass];
+	if (th)
+	    statespare[tclass] = th->next;
+	else
+	    th = Z_Malloc (statesizes[tclass], PU_LEVEL, NULL);
+	memcpy (th, save_p, statesizes[tclass]);
+	save_p += statesizes[tclass];
+
+	if (statesectors[tclass])
+	{
+	    sector = (sector_t **)((byte *)th + statesectors[tclass]);
+	    *sector = &sectors[(intptr_t)*sector];
+	}
+
+	dormant = !th->runprev;
+	P_AddThinker (th);
+	if (dormant)
+	    P_SleepThinker (th);
+	
+	if (tclass == ts_ceiling)
+	    P_AddActiveCeiling ((ceiling_t *)th);
+	else if (tclass == ts_plat)
+	    P_AddActivePlat ((plat_t *)th);
+	
+	statethinkers[i] = th;
+    }
+    numstatethinkers = count;
+
+    for (tclass = ts_mobj ; tclass < NUMSTATECLASSES ; tclass++)
+    {
+	for (th = statespare[tclass] ; th ; th = next)
+	{
+	    next = th->next;
+	    Z_Free (th);
+	}
+	statespare[tclass] = NULL;
+    }
+
+    for (i=0 ; i<numstatethinkers ; i++)
+    {
+	th = statethinkers[i];
+	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+	    continue;
+	
+	mobj = (mobj_t *)th;
+	mobj->target = P_ThinkerPtr ((intptr_t)mobj->target);
+	mobj->tracer = P_ThinkerPtr ((intptr_t)mobj->tracer);
+	mobj->snext = mobj->sprev = NULL;
+	mobj->bnext = mobj->bprev = NULL;
+	mobj->cnext = mobj->cprev = NULL;
+	mobj->touchsectors = NULL;
+    }
+
+    // players
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+
+	player = &players[i];
+	memcpy (player, save_p, sizeof(player_t));
+	save_p += sizeof(player_t);
+	player->mo = P_ThinkerPtr ((intptr_t)player->mo);
+	player->attacker = P_ThinkerPtr ((intptr_t)player->attacker);
+    }
+
+    // world
+    for (i=0, sec = sectors ; i<numsectors ; i++,sec++)
+    {
+	sec->floorheight = P_ReadInt ();
+	sec->ceilingheight = P_ReadInt ();
+	sec->floorpic = P_ReadInt ();
+	sec->ceilingpic = P_ReadInt ();
+	sec->lightlevel = P_ReadInt ();
+	sec->special = P_ReadInt ();
+	sec->tag = P_ReadInt ();
+	sec->soundtraversed = P_ReadInt ();
+	sec->soundtarget = P_ThinkerPtr (P_ReadInt ());
+	sec->specialdata = P_ThinkerPtr (P_ReadInt ());
+    }
+    
+    for (i=0, li = lines ; i<numlines ; i++,li++)
+    {
+	li->flags = P_ReadInt ();
+	li->special = P_ReadInt ();
+	li->tag = P_ReadInt ();
+    }
+
+    for (i=0, si = sides ; i<numsides ; i++,si++)
+    {
+	si->textureoffset = P_ReadInt ();
+	si->rowoffset = P_ReadInt ();
+	si->toptexture = P_ReadInt ();
+	si->bottomtexture = P_ReadInt ();
+	si->midtexture = P_ReadInt ();
+    }
+
+    // queues
+    bodyqueslot = P_ReadInt ();
+    for (i=0 ; i<BODYQUESIZE ; i++)
+	bodyque[i] = P_ThinkerPtr (P_ReadInt ());
+
+    numbraintargets = P_ReadInt ();
+    braintargeton = P_ReadInt ();
+    braineasy = P_ReadInt ();
+    for (i=0 ; i<numbraintargets ; i++)
+	braintargets[i] = P_ThinkerPtr (P_ReadInt ());
+
+    iquehead = P_ReadInt ();
+    iquetail = P_ReadInt ();
+    memcpy (itemrespawnque, save_p, sizeof(itemrespawnque));
+    save_p += sizeof(itemrespawnque);
+    memcpy (itemrespawntime, save_p, sizeof(itemrespawntime));
+    save_p += sizeof(itemrespawntime);
+
+    // buttons
+    P_ClearButtons ();
+    count = P_ReadInt ();
+    for (i=0 ; i<count ; i++)
+    {
+	li = &lines[P_ReadInt ()];
+	where = P_ReadInt ();
+	texture = P_ReadInt ();
+	P_StartButton (li, where, texture, P_ReadInt ());
+    }
+
+    // Set the things in the order they were first
+    // linked, which rebuilds every thing list as it was.
+    count = 0;
+    for (i=0 ; i<numstatethinkers ; i++)
+	if (statethinkers[i]->function.acp1 == (actionf_p1)P_MobjThinker)
+	    statethinkers[count++] = statethinkers[i];
+
+    qsort (statethinkers, count, sizeof(*statethinkers), P_CompareLinkStamps);
+    for (i=0 ; i<count ; i++)
+	P_SetThingPosition ((mobj_t *)statethinkers[i]);
+    numstatethinkers = 0;
+
+    P_ClearTeleportDests ();
+}
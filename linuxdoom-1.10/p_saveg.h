@@ -40,6 +40,11 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
+// In memory savestates of the level, see G_SnapshotState.
+int  P_StateSize (void);
+void P_ArchiveState (void);
+void P_UnArchiveState (void);
+
 extern byte*		save_p; 
 
 
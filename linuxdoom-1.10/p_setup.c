@@ -32,6 +32,7 @@ rcsid[] = "$Id: p_setup.c,v 1.5 1997/02/03 22:45:12 b1 Exp $";
 
 #include "m_swap.h"
 #include "m_bbox.h"
+#include "m_argv.h"
 
 #include "g_game.h"
 
@@ -85,14 +86,17 @@ side_t*		sides;
 // Blockmap size.
 int		bmapwidth;
 int		bmapheight;	// size in mapblocks
-short*		blockmap;	// int for larger maps
+int*		blockmap;	// int for larger maps
 // offsets in blockmap are from here
-short*		blockmaplump;		
+int*		blockmaplump;		
 // origin of block map
 fixed_t		bmaporgx;
 fixed_t		bmaporgy;
 // for thing chains
 mobj_t**	blocklinks;		
+// same, split into THINGCELLS x THINGCELLS per block
+mobj_t**	thingcells;
+fixed_t*	thingcellradius;
 
 
 // REJECT
@@ -175,12 +179,12 @@ void P_LoadSegs (int lump)
     li = segs;
     for (i=0 ; i<numsegs ; i++, li++, ml++)
     {
-	li->v1 = &vertexes[SHORT(ml->v1)];
-	li->v2 = &vertexes[SHORT(ml->v2)];
+	li->v1 = &vertexes[(unsigned short)SHORT(ml->v1)];
+	li->v2 = &vertexes[(unsigned short)SHORT(ml->v2)];
 					
 	li->angle = (SHORT(ml->angle))<<16;
 	li->offset = (SHORT(ml->offset))<<16;
-	linedef = SHORT(ml->linedef);
+	linedef = (unsigned short)SHORT(ml->linedef);
 	ldef = &lines[linedef];
 	li->linedef = ldef;
 	side = SHORT(ml->side);
@@ -216,8 +220,8 @@ void P_LoadSubsectors (int lump)
     
     for (i=0 ; i<numsubsectors ; i++, ss++, ms++)
     {
-	ss->numlines = SHORT(ms->numsegs);
-	ss->firstline = SHORT(ms->firstseg);
+	ss->numlines = (unsigned short)SHORT(ms->numsegs);
+	ss->firstline = (unsigned short)SHORT(ms->firstseg);
     }
 	
     Z_Free (data);
@@ -285,7 +289,10 @@ void P_LoadNodes (int lump)
 	no->dy = SHORT(mn->dy)<<FRACBITS;
 	for (j=0 ; j<2 ; j++)
 	{
-	    no->children[j] = SHORT(mn->children[j]);
+	    no->children[j] = (unsigned short)SHORT(mn->children[j]);
+	    if (no->children[j] & NF_MAPSUBSECTOR)
+		no->children[j] = (no->children[j] & ~NF_MAPSUBSECTOR)
+		    | NF_SUBSECTOR;
 	    for (k=0 ; k<4 ; k++)
 		no->bbox[j][k] = SHORT(mn->bbox[j][k])<<FRACBITS;
 	}
@@ -295,6 +302,183 @@ void P_LoadNodes (int lump)
 }
 
 
+//
+// Extended nodes.
+// The NODES lump may hold ZDBSP style uncompressed
+//  extended nodes instead, tagged "XNOD": 32 bit
+//  vertex, seg, subsector and child numbers, plus
+//  the extra vertexes created by splitting lines.
+//
+static byte*	xnodp;
+
+static unsigned int P_XNodLong (void)
+{
+    unsigned int	v;
+
+    v = xnodp[0] | (xnodp[1]<<8) | (xnodp[2]<<16)
+	| ((unsigned int)xnodp[3]<<24);
+    xnodp += 4;
+    return v;
+}
+
+static unsigned short P_XNodShort (void)
+{
+    unsigned short	v;
+
+    v = xnodp[0] | (xnodp[1]<<8);
+    xnodp += 2;
+    return v;
+}
+
+boolean P_CheckXNodes (int lump)
+{
+    byte*	data;
+    boolean	xnod;
+
+    if (W_LumpLength (lump) < 4)
+	return false;
+
+    data = W_CacheLumpNum (lump, PU_STATIC);
+    xnod = !memcmp (data, "XNOD", 4);
+    if (!xnod && !memcmp (data, "ZNOD", 4))
+	I_Error ("P_CheckXNodes: compressed ZNOD nodes not supported");
+    Z_Free (data);
+
+    return xnod;
+}
+
+
+//
+// P_LoadXNodes
+// Replaces P_LoadSubsectors, P_LoadNodes and P_LoadSegs.
+// Must be called after the linedefs are loaded,
+//  since the vertex table is grown.
+//
+void P_LoadXNodes (int lump)
+{
+    byte*		data;
+    int			i;
+    int			j;
+    int			k;
+    unsigned int	orgverts;
+    unsigned int	newverts;
+    vertex_t*		newvertexes;
+    line_t*		ld;
+    subsector_t*	ss;
+    int			firstseg;
+    seg_t*		li;
+    vertex_t*		from;
+    unsigned int	linedef;
+    int			side;
+    double		dx;
+    double		dy;
+    node_t*		no;
+    
+    data = W_CacheLumpNum (lump, PU_STATIC);
+    xnodp = data+4;
+
+    // vertexes: the originals are repeated as a count,
+    //  split vertexes follow
+    orgverts = P_XNodLong ();
+    newverts = P_XNodLong ();
+    if (orgverts != numvertexes)
+	I_Error ("P_LoadXNodes: %i vertexes, nodes built for %i",
+		 numvertexes, orgverts);
+
+    if (newverts)
+    {
+	newvertexes = Z_Malloc ((orgverts+newverts)*sizeof(vertex_t),
+				PU_LEVEL, 0);
+	memcpy (newvertexes, vertexes, orgverts*sizeof(vertex_t));
+	for (i=orgverts ; i<orgverts+newverts ; i++)
+	{
+	    newvertexes[i].x = P_XNodLong ();
+	    newvertexes[i].y = P_XNodLong ();
+	}
+
+	// relink the linedefs
+	ld = lines;
+	for (i=0 ; i<numlines ; i++, ld++)
+	{
+	    ld->v1 = newvertexes + (ld->v1 - vertexes);
+	    ld->v2 = newvertexes + (ld->v2 - vertexes);
+	}
+	Z_Free (vertexes);
+	vertexes = newvertexes;
+	numvertexes = orgverts+newverts;
+    }
+
+    // subsectors, as seg counts
+    numsubsectors = P_XNodLong ();
+    subsectors = Z_Malloc (numsubsectors*sizeof(subsector_t),PU_LEVEL,0);	
+    memset (subsectors,0, numsubsectors*sizeof(subsector_t));
+    ss = subsectors;
+    firstseg = 0;
+    for (i=0 ; i<numsubsectors ; i++, ss++)
+    {
+	ss->numlines = P_XNodLong ();
+	ss->firstline = firstseg;
+	firstseg += ss->numlines;
+    }
+
+    // segs, angle and offset are not stored
+    numsegs = P_XNodLong ();
+    if (numsegs != firstseg)
+	I_Error ("P_LoadXNodes: %i segs, subsectors use %i",
+		 numsegs, firstseg);
+    segs = Z_Malloc (numsegs*sizeof(seg_t),PU_LEVEL,0);	
+    memset (segs, 0, numsegs*sizeof(seg_t));
+    li = segs;
+    for (i=0 ; i<numsegs ; i++, li++)
+    {
+	li->v1 = &vertexes[P_XNodLong ()];
+	li->v2 = &vertexes[P_XNodLong ()];
+	linedef = P_XNodShort ();
+	side = *xnodp++;
+
+	if (linedef >= numlines)
+	    I_Error ("P_LoadXNodes: seg %i has no linedef", i);
+
+	ld = &lines[linedef];
+	li->linedef = ld;
+	li->sidedef = &sides[ld->sidenum[side]];
+	li->frontsector = sides[ld->sidenum[side]].sector;
+	if (ld-> flags & ML_TWOSIDED)
+	    li->backsector = sides[ld->sidenum[side^1]].sector;
+	else
+	    li->backsector = 0;
+
+	li->angle = R_PointToAngle2 (li->v1->x, li->v1->y,
+				     li->v2->x, li->v2->y);
+
+	// offset is measured from the start of the sidedef
+	from = side ? ld->v2 : ld->v1;
+	dx = (double)(li->v1->x - from->x);
+	dy = (double)(li->v1->y - from->y);
+	li->offset = (fixed_t)sqrt (dx*dx + dy*dy);
+    }
+
+    // nodes, children are 32 bit
+    numnodes = P_XNodLong ();
+    nodes = Z_Malloc (numnodes*sizeof(node_t),PU_LEVEL,0);	
+    no = nodes;
+    for (i=0 ; i<numnodes ; i++, no++)
+    {
+	no->x = (short)P_XNodShort ()<<FRACBITS;
+	no->y = (short)P_XNodShort ()<<FRACBITS;
+	no->dx = (short)P_XNodShort ()<<FRACBITS;
+	no->dy = (short)P_XNodShort ()<<FRACBITS;
+	for (j=0 ; j<2 ; j++)
+	    for (k=0 ; k<4 ; k++)
+		no->bbox[j][k] = (short)P_XNodShort ()<<FRACBITS;
+	for (j=0 ; j<2 ; j++)
+	    no->children[j] = P_XNodLong ();
+    }
+	
+    Z_Free (data);
+}
+
+
 //
 // P_LoadThings
 //
@@ -375,8 +559,8 @@ void P_LoadLineDefs (int lump)
 	ld->flags = SHORT(mld->flags);
 	ld->special = SHORT(mld->special);
 	ld->tag = SHORT(mld->tag);
-	v1 = ld->v1 = &vertexes[SHORT(mld->v1)];
-	v2 = ld->v2 = &vertexes[SHORT(mld->v2)];
+	v1 = ld->v1 = &vertexes[(unsigned short)SHORT(mld->v1)];
+	v2 = ld->v2 = &vertexes[(unsigned short)SHORT(mld->v2)];
 	ld->dx = v2->x - v1->x;
 	ld->dy = v2->y - v1->y;
 	
@@ -414,8 +598,11 @@ void P_LoadLineDefs (int lump)
 	    ld->bbox[BOXTOP] = v1->y;
 	}
 
-	ld->sidenum[0] = SHORT(mld->sidenum[0]);
-	ld->sidenum[1] = SHORT(mld->sidenum[1]);
+	// sidedef numbers are unsigned, 0xffff is no side
+	ld->sidenum[0] = SHORT(mld->sidenum[0]) == -1 ?
+	    -1 : (unsigned short)SHORT(mld->sidenum[0]);
+	ld->sidenum[1] = SHORT(mld->sidenum[1]) == -1 ?
+	    -1 : (unsigned short)SHORT(mld->sidenum[1]);
 
 	if (ld->sidenum[0] != -1)
 	    ld->frontsector = sides[ld->sidenum[0]].sector;
@@ -456,37 +643,197 @@ void P_LoadSideDefs (int lump)
 	sd->toptexture = R_TextureNumForName(msd->toptexture);
 	sd->bottomtexture = R_TextureNumForName(msd->bottomtexture);
 	sd->midtexture = R_TextureNumForName(msd->midtexture);
-	sd->sector = &sectors[SHORT(msd->sector)];
+	sd->sector = &sectors[(unsigned short)SHORT(msd->sector)];
     }
 	
     Z_Free (data);
 }
 
 
+//
+// P_CreateBlockMap
+// Builds a 32 bit blockmap from the linedefs,
+//  for maps without a usable BLOCKMAP lump.
+// Lists have the same layout as the lump,
+//  a leading 0 and a -1 terminator.
+//
+void P_CreateBlockMap (void)
+{
+    int		i;
+    int		pass;
+    int		x;
+    int		y;
+    int		x1;
+    int		x2;
+    int		y1;
+    int		y2;
+    fixed_t	minx;
+    fixed_t	miny;
+    fixed_t	maxx;
+    fixed_t	maxy;
+    int		numblocks;
+    int		count;
+    int*	fill;
+    line_t*	ld;
+    fixed_t	box[4];
+
+    minx = miny = MAXINT;
+    maxx = maxy = MININT;
+    for (i=0 ; i<numvertexes ; i++)
+    {
+	if (vertexes[i].x < minx)
+	    minx = vertexes[i].x;
+	if (vertexes[i].x > maxx)
+	    maxx = vertexes[i].x;
+	if (vertexes[i].y < miny)
+	    miny = vertexes[i].y;
+	if (vertexes[i].y > maxy)
+	    maxy = vertexes[i].y;
+    }
+
+    bmaporgx = minx;
+    bmaporgy = miny;
+    bmapwidth = ((maxx-bmaporgx)>>MAPBLOCKSHIFT) + 1;
+    bmapheight = ((maxy-bmaporgy)>>MAPBLOCKSHIFT) + 1;
+    numblocks = bmapwidth*bmapheight;
+
+    // lines per block, then fill position per block
+    fill = Z_Malloc (numblocks*sizeof(*fill), PU_STATIC, 0);
+    memset (fill, 0, numblocks*sizeof(*fill));
+
+    // first pass counts, second pass fills in the lists
+    for (pass=0 ; pass<2 ; pass++)
+    {
+	if (pass == 1)
+	{
+	    count = 4 + numblocks;
+	    for (i=0 ; i<numblocks ; i++)
+		count += fill[i] + 2;
+
+	    blockmaplump = Z_Malloc (count*sizeof(*blockmaplump),
+				     PU_LEVEL, 0);
+	    blockmap = blockmaplump+4;
+	    blockmaplump[0] = bmaporgx>>FRACBITS;
+	    blockmaplump[1] = bmaporgy>>FRACBITS;
+	    blockmaplump[2] = bmapwidth;
+	    blockmaplump[3] = bmapheight;
+
+	    count = 4 + numblocks;
+	    for (i=0 ; i<numblocks ; i++)
+	    {
+		blockmap[i] = count;
+		blockmaplump[count] = 0;
+		blockmaplump[count+fill[i]+1] = -1;
+		count += fill[i] + 2;
+		fill[i] = blockmap[i]+1;
+	    }
+	}
+	
+	ld = lines;
+	for (i=0 ; i<numlines ; i++, ld++)
+	{
+	    x1 = (ld->bbox[BOXLEFT]-bmaporgx)>>MAPBLOCKSHIFT;
+	    x2 = (ld->bbox[BOXRIGHT]-bmaporgx)>>MAPBLOCKSHIFT;
+	    y1 = (ld->bbox[BOXBOTTOM]-bmaporgy)>>MAPBLOCKSHIFT;
+	    y2 = (ld->bbox[BOXTOP]-bmaporgy)>>MAPBLOCKSHIFT;
+
+	    for (y=y1 ; y<=y2 ; y++)
+	    {
+		for (x=x1 ; x<=x2 ; x++)
+		{
+		    // axis aligned lines touch every block
+		    //  in their box, diagonals must split it
+		    if (ld->slopetype == ST_POSITIVE
+			|| ld->slopetype == ST_NEGATIVE)
+		    {
+			box[BOXLEFT] = bmaporgx + (x<<MAPBLOCKSHIFT);
+			box[BOXRIGHT] = box[BOXLEFT] + MAPBLOCKSIZE;
+			box[BOXBOTTOM] = bmaporgy + (y<<MAPBLOCKSHIFT);
+			box[BOXTOP] = box[BOXBOTTOM] + MAPBLOCKSIZE;
+			if (P_BoxOnLineSide (box, ld) != -1)
+			    continue;
+		    }
+
+		    if (pass == 0)
+			fill[y*bmapwidth+x]++;
+		    else
+			blockmaplump[fill[y*bmapwidth+x]++] = i;
+		}
+	    }
+	}
+    }
+
+    Z_Free (fill);
+}
+
+
 //
 // P_LoadBlockMap
+// Offsets and line numbers in the lump are unsigned,
+//  with 0xffff terminating each list. A missing,
+//  oversized or inconsistent lump is rebuilt.
 //
 void P_LoadBlockMap (int lump)
 {
     int		i;
     int		count;
+    short*	data;
+    boolean	valid;
 	
-    blockmaplump = W_CacheLumpNum (lump,PU_LEVEL);
-    blockmap = blockmaplump+4;
     count = W_LumpLength (lump)/2;
+    valid = false;
+
+    if (count >= 4 && count <= 0x10000 && !M_CheckParm ("-blockmap"))
+    {
+	data = W_CacheLumpNum (lump,PU_STATIC);
+	blockmaplump = Z_Malloc (count*sizeof(*blockmaplump), PU_LEVEL, 0);
+	blockmap = blockmaplump+4;
 
-    for (i=0 ; i<count ; i++)
-	blockmaplump[i] = SHORT(blockmaplump[i]);
+	for (i=0 ; i<4 ; i++)
+	    blockmaplump[i] = SHORT(data[i]);
+	for ( ; i<count ; i++)
+	{
+	    blockmaplump[i] = (unsigned short)SHORT(data[i]);
+	    if (blockmaplump[i] == 0xffff)
+		blockmaplump[i] = -1;
+	}
+	Z_Free (data);
 		
-    bmaporgx = blockmaplump[0]<<FRACBITS;
-    bmaporgy = blockmaplump[1]<<FRACBITS;
-    bmapwidth = blockmaplump[2];
-    bmapheight = blockmaplump[3];
+	bmaporgx = blockmaplump[0]<<FRACBITS;
+	bmaporgy = blockmaplump[1]<<FRACBITS;
+	bmapwidth = blockmaplump[2];
+	bmapheight = blockmaplump[3];
+
+	// every list must start inside the lump
+	valid = bmapwidth > 0 && bmapheight > 0
+	    && 4 + bmapwidth*bmapheight < count
+	    && blockmaplump[count-1] == -1;
+	for (i=0 ; valid && i<bmapwidth*bmapheight ; i++)
+	{
+	    if (blockmap[i] < 4 + bmapwidth*bmapheight
+		|| blockmap[i] >= count)
+		valid = false;
+	}
+
+	if (!valid)
+	    Z_Free (blockmaplump);
+    }
+
+    if (!valid)
+	P_CreateBlockMap ();
 	
     // clear out mobj chains
     count = sizeof(*blocklinks)* bmapwidth*bmapheight;
     blocklinks = Z_Malloc (count,PU_LEVEL, 0);
     memset (blocklinks, 0, count);
+
+    count = sizeof(*thingcells)*bmapwidth*bmapheight*THINGCELLS*THINGCELLS;
+    thingcells = Z_Malloc (count,PU_LEVEL, 0);
+    memset (thingcells, 0, count);
+    
+    count = sizeof(*thingcellradius)*bmapwidth*bmapheight*THINGCELLS*THINGCELLS;
+    thingcellradius = Z_Malloc (count,PU_LEVEL, 0);
+    memset (thingcellradius, 0, count);
 }
 
 
@@ -496,13 +843,20 @@ void P_LoadBlockMap (int lump)
 // Builds sector line lists and subsector sector numbers.
 // Finds block bounding boxes for sectors.
 //
+// The line tables are filled with a counting sort,
+// one pass over the lines instead of one per sector.
+// Each sector still gets its lines in linedef order.
+//
 void P_GroupLines (void)
 {
     line_t**		linebuffer;
+    sectoradj_t*	adjbuffer;
+    sector_t*		other;
     int			i;
     int			j;
     int			total;
     line_t*		li;
+    line_t**		lp;
     sector_t*		sector;
     subsector_t*	ss;
     seg_t*		seg;
@@ -532,25 +886,42 @@ void P_GroupLines (void)
 	}
     }
 	
-    // build line tables for each sector	
+    // carve out line tables for each sector,
+    // linecount is used as the fill index below
     linebuffer = Z_Malloc (total*sizeof(*linebuffer), PU_LEVEL, 0);
     sector = sectors;
     for (i=0 ; i<numsectors ; i++, sector++)
     {
-	M_ClearBox (bbox);
 	sector->lines = linebuffer;
-	li = lines;
-	for (j=0 ; j<numlines ; j++, li++)
+	linebuffer += sector->linecount;
+	sector->linecount = 0;
+    }
+
+    // distribute the lines, in order
+    li = lines;
+    for (i=0 ; i<numlines ; i++, li++)
+    {
+	sector = li->frontsector;
+	sector->lines[sector->linecount++] = li;
+
+	if (li->backsector && li->backsector != li->frontsector)
 	{
-	    if (li->frontsector == sector || li->backsector == sector)
-	    {
-		*linebuffer++ = li;
-		M_AddToBox (bbox, li->v1->x, li->v1->y);
-		M_AddToBox (bbox, li->v2->x, li->v2->y);
-	    }
+	    sector = li->backsector;
+	    sector->lines[sector->linecount++] = li;
+	}
+    }
+
+    sector = sectors;
+    for (i=0 ; i<numsectors ; i++, sector++)
+    {
+	M_ClearBox (bbox);
+	lp = sector->lines;
+	for (j=0 ; j<sector->linecount ; j++, lp++)
+	{
+	    li = *lp;
+	    M_AddToBox (bbox, li->v1->x, li->v1->y);
+	    M_AddToBox (bbox, li->v2->x, li->v2->y);
 	}
-	if (linebuffer - sector->lines != sector->linecount)
-	    I_Error ("P_GroupLines: miscounted");
 			
 	// set the degenmobj_t to the middle of the bounding box
 	sector->soundorg.x = (bbox[BOXRIGHT]+bbox[BOXLEFT])/2;
@@ -573,10 +944,67 @@ void P_GroupLines (void)
 	block = block < 0 ? 0 : block;
 	sector->blockbox[BOXLEFT]=block;
     }
+
+    // build the sector adjacency tables,
+    //  used by sound propagation and the
+    //  P_Find*Surrounding searches
+    total = 0;
+    sector = sectors;
+    for (i=0 ; i<numsectors ; i++, sector++)
+    {
+	sector->neighborcount = 0;
+	for (j=0 ; j<sector->linecount ; j++)
+	{
+	    if (getNextSector (sector->lines[j], sector))
+		sector->neighborcount++;
+	}
+	total += sector->neighborcount;
+    }
+
+    adjbuffer = Z_Malloc (total*sizeof(*adjbuffer), PU_LEVEL, 0);
+    sector = sectors;
+    for (i=0 ; i<numsectors ; i++, sector++)
+    {
+	sector->neighbors = adjbuffer;
+	for (j=0 ; j<sector->linecount ; j++)
+	{
+	    other = getNextSector (sector->lines[j], sector);
+	    if (!other)
+		continue;
+	    adjbuffer->sector = other;
+	    adjbuffer->line = sector->lines[j];
+	    adjbuffer++;
+	}
+    }
 	
 }
 
 
+//
+// P_InitTagLists
+// Hashes sectors by tag for the
+// P_FindSectorFromLineTag chains.
+// Built back to front, so each chain
+// runs in ascending index order.
+//
+void P_InitTagLists (void)
+{
+    int		i;
+    int		j;
+
+    for (i=0 ; i<numsectors ; i++)
+	sectors[i].firsttag = -1;
+
+    for (i=numsectors-1 ; i>=0 ; i--)
+    {
+	j = (unsigned)sectors[i].tag % (unsigned)numsectors;
+	sectors[i].nexttag = sectors[j].firsttag;
+	sectors[j].firsttag = i;
+    }
+}
+
+
+
 //
 // P_SetupLevel
 //
@@ -590,7 +1018,13 @@ P_SetupLevel
     int		i;
     char	lumpname[9];
     int		lumpnum;
+    long long	starttime;
+    long long	grouptime;
 	
+    // sight check counters for the level just left
+    if (devparm)
+	P_PrintSightStats ();
+
     totalkills = totalitems = totalsecret = wminfo.maxfrags = 0;
     wminfo.partime = 180;
     for (i=0 ; i<MAXPLAYERS ; i++)
@@ -618,8 +1052,8 @@ P_SetupLevel
 	Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
 
 
-    // UNUSED W_Profile ();
     P_InitThinkers ();
+    P_ClearSecNodes ();
 
     // if working with a devlopment map, reload it
     W_Reload ();			
@@ -644,20 +1078,32 @@ P_SetupLevel
     lumpnum = W_GetNumForName (lumpname);
 	
     leveltime = 0;
+    starttime = I_GetTimeUS ();
 	
     // note: most of this ordering is important	
-    P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
     P_LoadVertexes (lumpnum+ML_VERTEXES);
     P_LoadSectors (lumpnum+ML_SECTORS);
     P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
     P_LoadLineDefs (lumpnum+ML_LINEDEFS);
-    P_LoadSubsectors (lumpnum+ML_SSECTORS);
-    P_LoadNodes (lumpnum+ML_NODES);
-    P_LoadSegs (lumpnum+ML_SEGS);
+    // may be built from the linedefs
+    P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
+
+    if (P_CheckXNodes (lumpnum+ML_NODES))
+	P_LoadXNodes (lumpnum+ML_NODES);
+    else
+    {
+	P_LoadSubsectors (lumpnum+ML_SSECTORS);
+	P_LoadNodes (lumpnum+ML_NODES);
+	P_LoadSegs (lumpnum+ML_SEGS);
+    }
 	
     rejectmatrix = W_CacheLumpNum (lumpnum+ML_REJECT,PU_LEVEL);
+    grouptime = I_GetTimeUS ();
     P_GroupLines ();
+    grouptime = I_GetTimeUS () - grouptime;
+    P_InitTagLists ();
+    P_ClearTeleportDests ();
 
     bodyqueslot = 0;
     deathmatch_p = deathmatchstarts;
@@ -688,6 +1134,13 @@ P_SetupLevel
     if (precache)
 	R_PrecacheLevel ();
 
+    // load-time benchmark
+    if (devparm)
+	printf ("P_SetupLevel: %s, %i lines, %i sectors: "
+		"grouplines %i us, total %i us\n",
+		lumpname, numlines, numsectors,
+		(int)grouptime, (int)(I_GetTimeUS () - starttime));
+
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
 
 }
@@ -699,6 +1152,8 @@ P_SetupLevel
 //
 void P_Init (void)
 {
+    thinkerlists = M_CheckParm ("-thinkerlists");
+    sectorlists = M_CheckParm ("-sectorlists");
     P_InitSwitchList ();
     P_InitPicAnims ();
     R_InitSprites (sprnames);
@@ -44,7 +44,65 @@ divline_t	strace;			// from t1 to t2
 fixed_t		t2x;
 fixed_t		t2y;
 
-int		sightcounts[2];
+// rejected by REJECT, BSP walks, answered from the cache
+int		sightcounts[3];
+
+
+//
+// Sight cache.
+// A sight check only depends on the positions and heights
+//  of the looker and the target, and on sector heights.
+// Results are kept until the next tic, or until a plane
+//  moves, keyed on the positions, so a mobj that moved
+//  can never hit a stale entry.
+//
+#define SIGHTCACHESIZE	1024		// power of 2
+
+typedef struct
+{
+    int		generation;		// 0 is never valid
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	z1;
+    fixed_t	height1;
+    fixed_t	x2;
+    fixed_t	y2;
+    fixed_t	z2;
+    fixed_t	height2;
+    boolean	cansee;
+} sightcache_t;
+
+static sightcache_t	sightcache[SIGHTCACHESIZE];
+static int		sightgeneration = 1;
+
+
+//
+// P_ClearSightCache
+// Called every tic and whenever a sector height changes.
+//
+void P_ClearSightCache (void)
+{
+    sightgeneration++;
+}
+
+
+//
+// P_PrintSightStats
+// Reports and resets the counters, for -devparm.
+//
+void P_PrintSightStats (void)
+{
+    int		total;
+
+    total = sightcounts[1] + sightcounts[2];
+    if (total)
+	printf ("P_CheckSight: %i rejected, %i traced, %i cached "
+		"(%i%% hit rate)\n",
+		sightcounts[0], sightcounts[1], sightcounts[2],
+		sightcounts[2]*100/total);
+
+    sightcounts[0] = sightcounts[1] = sightcounts[2] = 0;
+}
 
 
 //
@@ -306,6 +364,8 @@ P_CheckSight
     int		pnum;
     int		bytenum;
     int		bitnum;
+    unsigned	hash;
+    sightcache_t*	sc;
     
     // First check for trivial rejection.
 
@@ -326,6 +386,23 @@ P_CheckSight
     }
 
     // An unobstructed LOS is possible.
+    // Seen the same way this tic?
+    hash = (unsigned)(t1->x>>FRACBITS) * 73856093u
+	^ (unsigned)(t1->y>>FRACBITS) * 19349663u
+	^ (unsigned)(t2->x>>FRACBITS) * 83492791u
+	^ (unsigned)(t2->y>>FRACBITS) * 2654435761u;
+    sc = &sightcache[(hash ^ (hash>>16)) & (SIGHTCACHESIZE-1)];
+
+    if (sc->generation == sightgeneration
+	&& sc->x1 == t1->x && sc->y1 == t1->y
+	&& sc->z1 == t1->z && sc->height1 == t1->height
+	&& sc->x2 == t2->x && sc->y2 == t2->y
+	&& sc->z2 == t2->z && sc->height2 == t2->height)
+    {
+	sightcounts[2]++;
+	return sc->cansee;
+    }
+
     // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
@@ -343,7 +420,18 @@ P_CheckSight
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    sc->generation = sightgeneration;
+    sc->x1 = t1->x;
+    sc->y1 = t1->y;
+    sc->z1 = t1->z;
+    sc->height1 = t1->height;
+    sc->x2 = t2->x;
+    sc->y2 = t2->y;
+    sc->z2 = t2->z;
+    sc->height2 = t2->height;
+    sc->cansee = P_CrossBSPNode (numnodes-1);
+
+    return sc->cansee;
 }
 
 
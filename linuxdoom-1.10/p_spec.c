@@ -64,6 +64,9 @@ typedef struct
     int		basepic;
     int		numpics;
     int		speed;
+
+    // leveltime/speed the translations were set for
+    int		frame;
     
 } anim_t;
 
@@ -138,10 +141,8 @@ anim_t*		lastanim;
 //
 //      Animating line specials
 //
-#define MAXLINEANIMS            64
-
-extern  short	numlinespecials;
-extern  line_t*	linespeciallist[MAXLINEANIMS];
+extern  int	numlinespecials;
+extern  line_t**	linespeciallist;
 
 
 
@@ -270,17 +271,12 @@ getNextSector
 fixed_t	P_FindLowestFloorSurrounding(sector_t* sec)
 {
     int			i;
-    line_t*		check;
     sector_t*		other;
     fixed_t		floor = sec->floorheight;
 	
-    for (i=0 ;i < sec->linecount ; i++)
+    for (i=0 ;i < sec->neighborcount ; i++)
     {
-	check = sec->lines[i];
-	other = getNextSector(check,sec);
-
-	if (!other)
-	    continue;
+	other = sec->neighbors[i].sector;
 	
 	if (other->floorheight < floor)
 	    floor = other->floorheight;
@@ -297,17 +293,12 @@ fixed_t	P_FindLowestFloorSurrounding(sector_t* sec)
 fixed_t	P_FindHighestFloorSurrounding(sector_t *sec)
 {
     int			i;
-    line_t*		check;
     sector_t*		other;
     fixed_t		floor = -500*FRACUNIT;
 	
-    for (i=0 ;i < sec->linecount ; i++)
+    for (i=0 ;i < sec->neighborcount ; i++)
     {
-	check = sec->lines[i];
-	other = getNextSector(check,sec);
-	
-	if (!other)
-	    continue;
+	other = sec->neighbors[i].sector;
 	
 	if (other->floorheight > floor)
 	    floor = other->floorheight;
@@ -333,20 +324,15 @@ P_FindNextHighestFloor
     int			i;
     int			h;
     int			min;
-    line_t*		check;
     sector_t*		other;
     fixed_t		height = currentheight;
 
     
     fixed_t		heightlist[MAX_ADJOINING_SECTORS];		
 
-    for (i=0, h=0 ;i < sec->linecount ; i++)
+    for (i=0, h=0 ;i < sec->neighborcount ; i++)
     {
-	check = sec->lines[i];
-	other = getNextSector(check,sec);
-
-	if (!other)
-	    continue;
+	other = sec->neighbors[i].sector;
 	
 	if (other->floorheight > height)
 	    heightlist[h++] = other->floorheight;
@@ -382,17 +368,12 @@ fixed_t
 P_FindLowestCeilingSurrounding(sector_t* sec)
 {
     int			i;
-    line_t*		check;
     sector_t*		other;
     fixed_t		height = MAXINT;
 	
-    for (i=0 ;i < sec->linecount ; i++)
+    for (i=0 ;i < sec->neighborcount ; i++)
     {
-	check = sec->lines[i];
-	other = getNextSector(check,sec);
-
-	if (!other)
-	    continue;
+	other = sec->neighbors[i].sector;
 
 	if (other->ceilingheight < height)
 	    height = other->ceilingheight;
@@ -407,17 +388,12 @@ P_FindLowestCeilingSurrounding(sector_t* sec)
 fixed_t	P_FindHighestCeilingSurrounding(sector_t* sec)
 {
     int		i;
-    line_t*	check;
     sector_t*	other;
     fixed_t	height = 0;
 	
-    for (i=0 ;i < sec->linecount ; i++)
+    for (i=0 ;i < sec->neighborcount ; i++)
     {
-	check = sec->lines[i];
-	other = getNextSector(check,sec);
-
-	if (!other)
-	    continue;
+	other = sec->neighbors[i].sector;
 
 	if (other->ceilingheight > height)
 	    height = other->ceilingheight;
@@ -430,18 +406,24 @@ fixed_t	P_FindHighestCeilingSurrounding(sector_t* sec)
 //
 // RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
 //
+// The sectors sharing a tag hash are chained in
+//  ascending order, so successive calls visit the
+//  same sectors in the same order as a full scan.
+//
 int
 P_FindSectorFromLineTag
 ( line_t*	line,
   int		start )
 {
-    int	i;
-	
-    for (i=start+1;i<numsectors;i++)
-	if (sectors[i].tag == line->tag)
-	    return i;
+    if (start >= 0)
+	start = sectors[start].nexttag;
+    else
+	start = sectors[(unsigned)line->tag % (unsigned)numsectors].firsttag;
+
+    while (start >= 0 && sectors[start].tag != line->tag)
+	start = sectors[start].nexttag;
     
-    return -1;
+    return start;
 }
 
 
@@ -457,17 +439,12 @@ P_FindMinSurroundingLight
 {
     int		i;
     int		min;
-    line_t*	line;
     sector_t*	check;
 	
     min = max;
-    for (i=0 ; i < sector->linecount ; i++)
+    for (i=0 ; i < sector->neighborcount ; i++)
     {
-	line = sector->lines[i];
-	check = getNextSector(line,sector);
-
-	if (!check)
-	    continue;
+	check = sector->neighbors[i].sector;
 
 	if (check->lightlevel < min)
 	    min = check->lightlevel;
@@ -1097,8 +1074,14 @@ void P_UpdateSpecials (void)
     }
     
     //	ANIMATE FLATS AND TEXTURES GLOBALLY
+    // The frames only depend on leveltime/speed,
+    //  so they are set again only when that changes.
     for (anim = anims ; anim < lastanim ; anim++)
     {
+	if (anim->frame == leveltime/anim->speed)
+	    continue;
+	anim->frame = leveltime/anim->speed;
+	
 	for (i=anim->basepic ; i<anim->basepic+anim->numpics ; i++)
 	{
 	    pic = anim->basepic + ( (leveltime/anim->speed + i)%anim->numpics );
@@ -1111,21 +1094,18 @@ void P_UpdateSpecials (void)
 
     
     //	ANIMATE LINE SPECIALS
+    // Only scrollers are on the list.
     for (i = 0; i < numlinespecials; i++)
     {
 	line = linespeciallist[i];
-	switch(line->special)
-	{
-	  case 48:
-	    // EFFECT FIRSTCOL SCROLL +
-	    sides[line->sidenum[0]].textureoffset += FRACUNIT;
-	    break;
-	}
+
+	// EFFECT FIRSTCOL SCROLL +
+	sides[line->sidenum[0]].textureoffset += FRACUNIT;
     }
 
     
     //	DO BUTTONS
-    for (i = 0; i < MAXBUTTONS; i++)
+    for (i = 0; i < numbuttons; i++)
 	if (buttonlist[i].btimer)
 	{
 	    buttonlist[i].btimer--;
@@ -1148,7 +1128,7 @@ void P_UpdateSpecials (void)
 			buttonlist[i].btexture;
 		    break;
 		}
-		S_StartSound((mobj_t *)&buttonlist[i].soundorg,sfx_swtchn);
+		S_StartSound(buttonlist[i].soundorg,sfx_swtchn);
 		memset(&buttonlist[i],0,sizeof(button_t));
 	    }
 	}
@@ -1231,8 +1211,8 @@ int EV_DoDonut(line_t*	line)
 // After the map has been loaded, scan for specials
 //  that spawn thinkers
 //
-short		numlinespecials;
-line_t*		linespeciallist[MAXLINEANIMS];
+int		numlinespecials;
+line_t**	linespeciallist;
 
 
 // Parses command line parameters.
@@ -1241,6 +1221,7 @@ void P_SpawnSpecials (void)
     sector_t*	sector;
     int		i;
     int		episode;
+    anim_t*	anim;
 
     episode = 1;
     if (W_CheckNumForName("texture2") >= 0)
@@ -1333,6 +1314,14 @@ void P_SpawnSpecials (void)
 
     
     //	Init line EFFECTs
+    // Count the scrollers first, there is no limit.
+    numlinespecials = 0;
+    for (i = 0;i < numlines; i++)
+	if (lines[i].special == 48)
+	    numlinespecials++;
+
+    linespeciallist = Z_Malloc ((numlinespecials+1)*sizeof(*linespeciallist),
+				PU_LEVEL, 0);
     numlinespecials = 0;
     for (i = 0;i < numlines; i++)
     {
@@ -1346,16 +1335,19 @@ void P_SpawnSpecials (void)
 	}
     }
 
+    // set every animation on the first update
+    for (anim = anims ; anim < lastanim ; anim++)
+	anim->frame = -1;
+
     
     //	Init other misc stuff
-    for (i = 0;i < MAXCEILINGS;i++)
+    for (i = 0;i < ACTIVEHASH;i++)
 	activeceilings[i] = NULL;
 
-    for (i = 0;i < MAXPLATS;i++)
+    for (i = 0;i < ACTIVEHASH;i++)
 	activeplats[i] = NULL;
     
-    for (i = 0;i < MAXBUTTONS;i++)
-	memset(&buttonlist[i],0,sizeof(button_t));
+    P_ClearButtons ();
 
     // UNUSED: no horizonal sliders.
     //	P_InitSlidingDoorFrames();
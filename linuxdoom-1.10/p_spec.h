@@ -178,6 +178,7 @@ typedef struct
 #define FASTDARK			15
 #define SLOWDARK			35
 
+void    T_FireFlicker (fireflicker_t* flick);
 void    P_SpawnFireFlicker (sector_t* sector);
 void    T_LightFlash (lightflash_t* flash);
 void    P_SpawnLightFlash (sector_t* sector);
@@ -200,6 +201,11 @@ EV_LightTurnOn
 void    T_Glow(glow_t* g);
 void    P_SpawnGlowingLight(sector_t* sector);
 
+boolean P_IsLightThinker (thinker_t* th);
+void    P_RunLightBatches (thinker_t* cap);
+void    P_FlushLightBatches (void);
+void    P_ClearLightBatches (void);
+
 
 
 
@@ -240,13 +246,24 @@ typedef struct
  // max # of wall switches in a level
 #define MAXSWITCHES		50
 
- // 4 players, 4 buttons each at once, max.
+ // 4 players, 4 buttons each at once.
+ // Initial size, buttonlist grows as needed.
 #define MAXBUTTONS		16
 
  // 1 second, in ticks. 
 #define BUTTONTIME      35             
 
-extern button_t	buttonlist[MAXBUTTONS]; 
+extern button_t*	buttonlist; 
+extern int		numbuttons;
+
+void P_ClearButtons (void);
+
+void
+P_StartButton
+( line_t*	line,
+  bwhere_e	w,
+  int		texture,
+  int		time );
 
 void
 P_ChangeSwitchTexture
@@ -282,7 +299,7 @@ typedef enum
 
 
 
-typedef struct
+typedef struct plat_s
 {
     thinker_t	thinker;
     sector_t*	sector;
@@ -296,6 +313,10 @@ typedef struct
     boolean	crush;
     int		tag;
     plattype_e	type;
+
+    // activeplats chain for the tag
+    struct plat_s*	tprev;
+    struct plat_s*	tnext;
     
 } plat_t;
 
@@ -303,10 +324,13 @@ typedef struct
 
 #define PLATWAIT		3
 #define PLATSPEED		FRACUNIT
-#define MAXPLATS		30
 
+// The active plats and ceilings are chained by
+//  tag in ACTIVEHASH buckets, with no limit.
+#define ACTIVEHASH		64
+#define ACTIVEHASHKEY(tag)	((unsigned)(tag)%ACTIVEHASH)
 
-extern plat_t*	activeplats[MAXPLATS];
+extern plat_t*	activeplats[ACTIVEHASH];
 
 void    T_PlatRaise(plat_t*	plat);
 
@@ -318,6 +342,7 @@ EV_DoPlat
 
 void    P_AddActivePlat(plat_t* plat);
 void    P_RemoveActivePlat(plat_t* plat);
+boolean P_IsActivePlat(plat_t* plat);
 void    EV_StopPlat(line_t* line);
 void    P_ActivateInStasis(int tag);
 
@@ -490,7 +515,7 @@ typedef enum
 
 
 
-typedef struct
+typedef struct ceiling_s
 {
     thinker_t	thinker;
     ceiling_e	type;
@@ -506,6 +531,10 @@ typedef struct
     // ID
     int		tag;                   
     int		olddirection;
+
+    // activeceilings chain for the tag
+    struct ceiling_s*	tprev;
+    struct ceiling_s*	tnext;
     
 } ceiling_t;
 
@@ -515,9 +544,8 @@ typedef struct
 
 #define CEILSPEED		FRACUNIT
 #define CEILWAIT		150
-#define MAXCEILINGS		30
 
-extern ceiling_t*	activeceilings[MAXCEILINGS];
+extern ceiling_t*	activeceilings[ACTIVEHASH];
 
 int
 EV_DoCeiling
@@ -527,6 +555,7 @@ EV_DoCeiling
 void    T_MoveCeiling (ceiling_t* ceiling);
 void    P_AddActiveCeiling(ceiling_t* c);
 void    P_RemoveActiveCeiling(ceiling_t* c);
+boolean P_IsActiveCeiling(ceiling_t* c);
 int	EV_CeilingCrushStop(line_t* line);
 void    P_ActivateInStasisCeiling(line_t* line);
 
@@ -637,6 +666,8 @@ EV_Teleport
   int		side,
   mobj_t*	thing );
 
+void P_ClearTeleportDests (void);
+
 #endif
 //-----------------------------------------------------------------------------
 //
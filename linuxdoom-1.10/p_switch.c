@@ -26,6 +26,9 @@ static const char
 rcsid[] = "$Id: p_switch.c,v 1.3 1997/01/28 22:08:29 b1 Exp $";
 
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "i_system.h"
 #include "doomdef.h"
 #include "p_local.h"
@@ -98,7 +101,8 @@ switchlist_t alphSwitchList[] =
 
 int		switchlist[MAXSWITCHES * 2];
 int		numswitches;
-button_t        buttonlist[MAXBUTTONS];
+button_t*       buttonlist;
+int		numbuttons;
 
 //
 // P_InitSwitchList
@@ -161,7 +165,7 @@ P_StartButton
     int		i;
     
     // See if button is already pressed
-    for (i = 0;i < MAXBUTTONS;i++)
+    for (i = 0;i < numbuttons;i++)
     {
 	if (buttonlist[i].btimer
 	    && buttonlist[i].line == line)
@@ -173,20 +177,44 @@ P_StartButton
     
 
     
-    for (i = 0;i < MAXBUTTONS;i++)
-    {
+    for (i = 0;i < numbuttons;i++)
 	if (!buttonlist[i].btimer)
-	{
-	    buttonlist[i].line = line;
-	    buttonlist[i].where = w;
-	    buttonlist[i].btexture = texture;
-	    buttonlist[i].btimer = time;
-	    buttonlist[i].soundorg = (mobj_t *)&line->frontsector->soundorg;
-	    return;
-	}
+	    break;
+
+    // all in use, make room for more
+    if (i == numbuttons)
+    {
+	buttonlist = realloc (buttonlist, 2*numbuttons*sizeof(*buttonlist));
+	if (!buttonlist)
+	    I_Error("P_StartButton: couldn't grow to %i", 2*numbuttons);
+	memset (&buttonlist[numbuttons],0,numbuttons*sizeof(*buttonlist));
+	numbuttons *= 2;
     }
     
-    I_Error("P_StartButton: no button slots left!");
+    buttonlist[i].line = line;
+    buttonlist[i].where = w;
+    buttonlist[i].btexture = texture;
+    buttonlist[i].btimer = time;
+    buttonlist[i].soundorg = (mobj_t *)&line->frontsector->soundorg;
+}
+
+
+
+//
+// P_ClearButtons
+// Called at level start, the list
+// starts at MAXBUTTONS and is kept.
+//
+void P_ClearButtons (void)
+{
+    if (!buttonlist)
+    {
+	numbuttons = MAXBUTTONS;
+	buttonlist = malloc (numbuttons*sizeof(*buttonlist));
+	if (!buttonlist)
+	    I_Error ("P_ClearButtons: couldn't allocate buttons");
+    }
+    memset (buttonlist,0,numbuttons*sizeof(*buttonlist));
 }
 
 
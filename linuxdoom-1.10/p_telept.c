@@ -41,6 +41,59 @@ rcsid[] = "$Id: p_telept.c,v 1.3 1997/01/28 22:08:29 b1 Exp $";
 
 
 
+static boolean	teledestsvalid;
+
+
+//
+// P_ClearTeleportDests
+// Called when a teleport destination is spawned
+// or removed; the table is rebuilt on next use.
+//
+void P_ClearTeleportDests (void)
+{
+    teledestsvalid = false;
+}
+
+
+//
+// P_InitTeleportDests
+// Records the first MT_TELEPORTMAN of each sector,
+// in thinker order, as one thinker walk replaces
+// the walk per teleport.
+//
+static void P_InitTeleportDests (void)
+{
+    int		i;
+    thinker_t*	thinker;
+    mobj_t*	m;
+    sector_t*	sector;
+
+    for (i = 0; i < numsectors; i++)
+	sectors[i].teledest = NULL;
+
+    for (thinker = thinkercap.next;
+	 thinker != &thinkercap;
+	 thinker = thinker->next)
+    {
+	// not a mobj
+	if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
+	    continue;	
+
+	m = (mobj_t *)thinker;
+		
+	// not a teleportman
+	if (m->type != MT_TELEPORTMAN )
+	    continue;		
+
+	sector = m->subsector->sector;
+	if (!sector->teledest)
+	    sector->teledest = m;
+    }
+
+    teledestsvalid = true;
+}
+
+
 //
 // TELEPORTATION
 //
@@ -51,12 +104,9 @@ EV_Teleport
   mobj_t*	thing )
 {
     int		i;
-    int		tag;
     mobj_t*	m;
     mobj_t*	fog;
     unsigned	an;
-    thinker_t*	thinker;
-    sector_t*	sector;
     fixed_t	oldx;
     fixed_t	oldy;
     fixed_t	oldz;
@@ -71,61 +121,46 @@ EV_Teleport
 	return 0;	
 
     
-    tag = line->tag;
-    for (i = 0; i < numsectors; i++)
+    if (!teledestsvalid)
+	P_InitTeleportDests ();
+
+    i = -1;
+    while ((i = P_FindSectorFromLineTag(line,i)) >= 0)
     {
-	if (sectors[ i ].tag == tag )
-	{
-	    thinker = thinkercap.next;
-	    for (thinker = thinkercap.next;
-		 thinker != &thinkercap;
-		 thinker = thinker->next)
-	    {
-		// not a mobj
-		if (thinker->function.acp1 != (actionf_p1)P_MobjThinker)
-		    continue;	
-
-		m = (mobj_t *)thinker;
-		
-		// not a teleportman
-		if (m->type != MT_TELEPORTMAN )
-		    continue;		
-
-		sector = m->subsector->sector;
-		// wrong sector
-		if (sector-sectors != i )
-		    continue;	
-
-		oldx = thing->x;
-		oldy = thing->y;
-		oldz = thing->z;
+	m = sectors[i].teledest;
+
+	// no destination in this sector
+	if (!m)
+	    continue;
+
+	oldx = thing->x;
+	oldy = thing->y;
+	oldz = thing->z;
 				
-		if (!P_TeleportMove (thing, m->x, m->y))
-		    return 0;
+	if (!P_TeleportMove (thing, m->x, m->y))
+	    return 0;
 		
-		thing->z = thing->floorz;  //fixme: not needed?
-		if (thing->player)
-		    thing->player->viewz = thing->z+thing->player->viewheight;
+	thing->z = thing->floorz;  //fixme: not needed?
+	if (thing->player)
+	    thing->player->viewz = thing->z+thing->player->viewheight;
 				
-		// spawn teleport fog at source and destination
-		fog = P_SpawnMobj (oldx, oldy, oldz, MT_TFOG);
-		S_StartSound (fog, sfx_telept);
-		an = m->angle >> ANGLETOFINESHIFT;
-		fog = P_SpawnMobj (m->x+20*finecosine[an], m->y+20*finesine[an]
-				   , thing->z, MT_TFOG);
-
-		// emit sound, where?
-		S_StartSound (fog, sfx_telept);
+	// spawn teleport fog at source and destination
+	fog = P_SpawnMobj (oldx, oldy, oldz, MT_TFOG);
+	S_StartSound (fog, sfx_telept);
+	an = m->angle >> ANGLETOFINESHIFT;
+	fog = P_SpawnMobj (m->x+20*finecosine[an], m->y+20*finesine[an]
+			   , thing->z, MT_TFOG);
+
+	// emit sound, where?
+	S_StartSound (fog, sfx_telept);
 		
-		// don't move for a bit
-		if (thing->player)
-		    thing->reactiontime = 18;	
-
-		thing->angle = m->angle;
-		thing->momx = thing->momy = thing->momz = 0;
-		return 1;
-	    }	
-	}
+	// don't move for a bit
+	if (thing->player)
+	    thing->reactiontime = 18;	
+
+	thing->angle = m->angle;
+	thing->momx = thing->momy = thing->momz = 0;
+	return 1;
     }
     return 0;
 }
@@ -27,6 +27,7 @@ rcsid[] = "$Id: p_tick.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_tick.h"
 
 #include "doomstat.h"
 
@@ -46,6 +47,16 @@ int	leveltime;
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+// With -thinkerlists, outside of demos and netgames,
+// the light thinkers are moved to their own list
+// and run in batches after all other thinkers.
+// Lights draw random numbers, so this changes the
+// order of P_Random calls against a normal run.
+boolean		thinkerlists;
+
+static thinker_t	lightcap;
+static boolean		lightsbatched;
+
 
 //
 // P_InitThinkers
@@ -53,6 +64,10 @@ thinker_t	thinkercap;
 void P_InitThinkers (void)
 {
     thinkercap.prev = thinkercap.next  = &thinkercap;
+    thinkercap.runprev = thinkercap.runnext = &thinkercap;
+    lightcap.prev = lightcap.next = &lightcap;
+    lightsbatched = false;
+    P_ClearLightBatches ();
 }
 
 
@@ -64,10 +79,30 @@ void P_InitThinkers (void)
 //
 void P_AddThinker (thinker_t* thinker)
 {
-    thinkercap.prev->next = thinker;
-    thinker->next = &thinkercap;
-    thinker->prev = thinkercap.prev;
-    thinkercap.prev = thinker;
+    thinker_t*	cap;
+
+    cap = &thinkercap;
+    if (lightsbatched && P_IsLightThinker (thinker))
+    {
+	cap = &lightcap;
+	P_FlushLightBatches ();
+	
+	// never dormant, see P_WakeThinker
+	thinker->runprev = thinker->runnext = thinker;
+    }
+	
+    cap->prev->next = thinker;
+    thinker->next = cap;
+    thinker->prev = cap->prev;
+    cap->prev = thinker;
+
+    if (cap == &thinkercap)
+    {
+	thinkercap.runprev->runnext = thinker;
+	thinker->runnext = &thinkercap;
+	thinker->runprev = thinkercap.runprev;
+	thinkercap.runprev = thinker;
+    }
 }
 
 
@@ -79,12 +114,125 @@ void P_AddThinker (thinker_t* thinker)
 //
 void P_RemoveThinker (thinker_t* thinker)
 {
+  if (lightsbatched && P_IsLightThinker (thinker))
+      P_FlushLightBatches ();
+
+  // so it is freed when its turn comes up
+  P_WakeThinker (thinker);
+	
   // FIXME: NOP.
   thinker->function.acv = (actionf_v)(-1);
 }
 
 
 
+//
+// P_SleepThinker
+// Takes a thinker off the run list until
+// P_WakeThinker. Only for mobjs whose
+// P_MobjThinker would do nothing, see there.
+// Its own runnext is kept, as P_RunThinkers
+// may still be about to follow it.
+//
+void P_SleepThinker (thinker_t* thinker)
+{
+    if (!thinker->runprev)
+	return;
+	
+    thinker->runprev->runnext = thinker->runnext;
+    thinker->runnext->runprev = thinker->runprev;
+    thinker->runprev = NULL;
+}
+
+
+
+//
+// P_WakeThinker
+// Puts a thinker back on the run list,
+// ahead of the next running thinker after it
+// on the full list, so everything still runs
+// in the original order.
+//
+void P_WakeThinker (thinker_t* thinker)
+{
+    thinker_t*	next;
+	
+    if (thinker->runprev)
+	return;
+
+    next = thinker->next;
+    while (next != &thinkercap && !next->runprev)
+	next = next->next;
+
+    thinker->runnext = next;
+    thinker->runprev = next->runprev;
+    next->runprev->runnext = thinker;
+    next->runprev = thinker;
+}
+
+
+
+//
+// P_SetThinkerLists
+// Moves the light thinkers between the main list
+// and their own. Putting them back appends them,
+// so everything that walks thinkercap sees all
+// thinkers again.
+//
+void P_SetThinkerLists (boolean on)
+{
+    thinker_t*	th;
+    thinker_t*	next;
+	
+    if (on == lightsbatched)
+	return;
+
+    if (on)
+    {
+	for (th = thinkercap.next ; th != &thinkercap ; th = next)
+	{
+	    next = th->next;
+	    if (!P_IsLightThinker (th))
+		continue;
+	    
+	    th->next->prev = th->prev;
+	    th->prev->next = th->next;
+	    th->runnext->runprev = th->runprev;
+	    th->runprev->runnext = th->runnext;
+	    th->runprev = th->runnext = th;
+	    
+	    lightcap.prev->next = th;
+	    th->next = &lightcap;
+	    th->prev = lightcap.prev;
+	    lightcap.prev = th;
+	}
+    }
+    else
+    {
+	P_FlushLightBatches ();
+	
+	for (th = lightcap.next ; th != &lightcap ; th = next)
+	{
+	    next = th->next;
+	    
+	    thinkercap.prev->next = th;
+	    th->next = &thinkercap;
+	    th->prev = thinkercap.prev;
+	    thinkercap.prev = th;
+	    
+	    thinkercap.runprev->runnext = th;
+	    th->runnext = &thinkercap;
+	    th->runprev = thinkercap.runprev;
+	    thinkercap.runprev = th;
+	}
+	lightcap.prev = lightcap.next = &lightcap;
+    }
+    
+    lightsbatched = on;
+}
+
+
+
 //
 // P_AllocateThinker
 // Allocates memory and adds a new thinker at the end of the list.
@@ -102,7 +250,13 @@ void P_RunThinkers (void)
 {
     thinker_t*	currentthinker;
 
-    currentthinker = thinkercap.next;
+    // demos and netgames need the original order
+    P_SetThinkerLists (thinkerlists
+		       && !demoplayback
+		       && !demorecording
+		       && !netgame);
+
+    currentthinker = thinkercap.runnext;
     while (currentthinker != &thinkercap)
     {
 	if ( currentthinker->function.acv == (actionf_v)(-1) )
@@ -110,6 +264,8 @@ void P_RunThinkers (void)
 	    // time to remove it
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
+	    currentthinker->runnext->runprev = currentthinker->runprev;
+	    currentthinker->runprev->runnext = currentthinker->runnext;
 	    Z_Free (currentthinker);
 	}
 	else
@@ -117,8 +273,11 @@ void P_RunThinkers (void)
 	    if (currentthinker->function.acp1)
 		currentthinker->function.acp1 (currentthinker);
 	}
-	currentthinker = currentthinker->next;
+	currentthinker = currentthinker->runnext;
     }
+
+    if (lightsbatched)
+	P_RunLightBatches (&lightcap);
 }
 
 
@@ -145,6 +304,9 @@ void P_Ticker (void)
     }
     
 		
+    // sight checks are only cached within a tic
+    P_ClearSightCache ();
+
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
 	    P_PlayerThink (&players[i]);
@@ -156,3 +318,93 @@ void P_Ticker (void)
     // for par times
     leveltime++;	
 }
+
+
+
+//
+// P_SyncHash
+// Hashes the parts of the level state that a demo
+// or netgame must reproduce exactly, one sum per
+// synchash_e. A single pass over the thinkers and
+// sectors, so it can be run every tic. It is worked
+// out whole each time rather than kept up as things
+// change, which would need a hook on every write to
+// a hashed field all through the playsim.
+//
+char*	synchashnames[NUMSYNCHASH] =
+{
+    "rng", "mobjs", "players", "sectors"
+};
+
+#define HASHMIX(h,v)	((h) = ((h) ^ (unsigned)(v)) * 16777619u)
+
+void P_SyncHash (unsigned* sums)
+{
+    extern int	prndindex;
+    thinker_t*	th;
+    mobj_t*	mo;
+    player_t*	p;
+    sector_t*	sec;
+    unsigned	h;
+    int		i;
+    int		j;
+
+    h = 2166136261u;
+    HASHMIX (h, prndindex);
+    HASHMIX (h, leveltime);
+    sums[sh_rng] = h;
+
+    h = 2166136261u;
+    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    {
+	if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+	    continue;
+	mo = (mobj_t *)th;
+	HASHMIX (h, mo->type);
+	HASHMIX (h, mo->x);
+	HASHMIX (h, mo->y);
+	HASHMIX (h, mo->z);
+	HASHMIX (h, mo->angle);
+	HASHMIX (h, mo->momx);
+	HASHMIX (h, mo->momy);
+	HASHMIX (h, mo->momz);
+	HASHMIX (h, mo->health);
+	HASHMIX (h, mo->state - states);
+	HASHMIX (h, mo->tics);
+	HASHMIX (h, mo->flags);
+	HASHMIX (h, mo->movedir);
+	HASHMIX (h, mo->movecount);
+	HASHMIX (h, mo->reactiontime);
+    }
+    sums[sh_mobjs] = h;
+
+    h = 2166136261u;
+    for (i=0 ; i<MAXPLAYERS ; i++)
+    {
+	if (!playeringame[i])
+	    continue;
+	p = &players[i];
+	HASHMIX (h, p->playerstate);
+	HASHMIX (h, p->health);
+	HASHMIX (h, p->armorpoints);
+	HASHMIX (h, p->readyweapon);
+	HASHMIX (h, p->pendingweapon);
+	HASHMIX (h, p->viewz);
+	for (j=0 ; j<NUMAMMO ; j++)
+	    HASHMIX (h, p->ammo[j]);
+	for (j=0 ; j<NUMPSPRITES ; j++)
+	    HASHMIX (h, p->psprites[j].state
+		     ? p->psprites[j].state - states : -1);
+    }
+    sums[sh_players] = h;
+
+    h = 2166136261u;
+    for (i=0, sec=sectors ; i<numsectors ; i++, sec++)
+    {
+	HASHMIX (h, sec->floorheight);
+	HASHMIX (h, sec->ceilingheight);
+	HASHMIX (h, sec->lightlevel);
+	HASHMIX (h, sec->special);
+    }
+    sums[sh_sectors] = h;
+}
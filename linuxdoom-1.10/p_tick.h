@@ -35,6 +35,25 @@
 void P_Ticker (void);
 
 
+//
+// Sync hash, one sum per subsystem so a
+// desync can be traced to where it started.
+//
+typedef enum
+{
+    sh_rng,
+    sh_mobjs,
+    sh_players,
+    sh_sectors,
+    NUMSYNCHASH
+    
+} synchash_e;
+
+extern char*	synchashnames[NUMSYNCHASH];
+
+void P_SyncHash (unsigned* sums);
+
+
 
 #endif
 //-----------------------------------------------------------------------------
@@ -29,9 +29,11 @@ rcsid[] = "$Id: r_data.c,v 1.4 1997/02/03 16:47:55 b1 Exp $";
 
 #include <stdint.h>
 #include "i_system.h"
+#include "i_thread.h"
 #include "z_zone.h"
 
 #include "m_swap.h"
+#include "m_argv.h"
 
 #include "w_wad.h"
 
@@ -146,6 +148,9 @@ int		numspritelumps;
 int		numtextures;
 texture_t**	textures;
 
+// Column lookups are built on first use, see R_GetColumn.
+boolean		lazytextures;
+
 
 int*			texturewidthmask;
 // needed for texture pegging
@@ -224,6 +229,59 @@ R_DrawColumnInCache
 
 
 
+//
+// R_CompositePatch
+// Draws the multi patch columns covered by one patch
+//  of a texture into its composite block.
+// Touches no zone memory, so precache workers can run it.
+//
+void
+R_CompositePatch
+( int		texnum,
+  texpatch_t*	patch,
+  patch_t*	realpatch,
+  byte*		block )
+{
+    texture_t*		texture;
+    int			x;
+    int			x1;
+    int			x2;
+    column_t*		patchcol;
+    short*		collump;
+    unsigned short*	colofs;
+	
+    texture = textures[texnum];
+    collump = texturecolumnlump[texnum];
+    colofs = texturecolumnofs[texnum];
+
+    x1 = patch->originx;
+    x2 = x1 + SHORT(realpatch->width);
+
+    if (x1<0)
+	x = 0;
+    else
+	x = x1;
+	
+    if (x2 > texture->width)
+	x2 = texture->width;
+
+    for ( ; x<x2 ; x++)
+    {
+	// Column does not have multiple patches?
+	if (collump[x] >= 0)
+	    continue;
+	    
+	patchcol = (column_t *)((byte *)realpatch
+				+ LONG(realpatch->columnofs[x-x1]));
+	R_DrawColumnInCache (patchcol,
+			     block + colofs[x],
+			     patch->originy,
+			     texture->height);
+    }
+}
+
+
+
 //
 // R_GenerateComposite
 // Using the texture definition,
@@ -235,14 +293,7 @@ void R_GenerateComposite (int texnum)
     byte*		block;
     texture_t*		texture;
     texpatch_t*		patch;	
-    patch_t*		realpatch;
-    int			x;
-    int			x1;
-    int			x2;
     int			i;
-    column_t*		patchcol;
-    short*		collump;
-    unsigned short*	colofs;
 	
     texture = textures[texnum];
 
@@ -250,42 +301,14 @@ void R_GenerateComposite (int texnum)
 		      PU_STATIC, 
 		      &texturecomposite[texnum]);	
 
-    collump = texturecolumnlump[texnum];
-    colofs = texturecolumnofs[texnum];
-    
     // Composite the columns together.
-    patch = texture->patches;
-		
     for (i=0 , patch = texture->patches;
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
-	x1 = patch->originx;
-	x2 = x1 + SHORT(realpatch->width);
-
-	if (x1<0)
-	    x = 0;
-	else
-	    x = x1;
-	
-	if (x2 > texture->width)
-	    x2 = texture->width;
-
-	for ( ; x<x2 ; x++)
-	{
-	    // Column does not have multiple patches?
-	    if (collump[x] >= 0)
-		continue;
-	    
-	    patchcol = (column_t *)((byte *)realpatch
-				    + LONG(realpatch->columnofs[x-x1]));
-	    R_DrawColumnInCache (patchcol,
-				 block + colofs[x],
-				 patch->originy,
-				 texture->height);
-	}
-						
+	R_CompositePatch (texnum, patch,
+			  W_CacheLumpNum (patch->patch, PU_CACHE),
+			  block);
     }
 
     // Now that the texture has been built in column cache,
@@ -297,6 +320,8 @@ void R_GenerateComposite (int texnum)
 
 //
 // R_GenerateLookup
+// With -lazytextures this runs the first time
+//  the texture is drawn or precached.
 //
 void R_GenerateLookup (int texnum)
 {
@@ -313,6 +338,12 @@ void R_GenerateLookup (int texnum)
 	
     texture = textures[texnum];
 
+    if (!texturecolumnlump[texnum])
+    {
+	texturecolumnlump[texnum] = Z_Malloc (texture->width*2, PU_STATIC,0);
+	texturecolumnofs[texnum] = Z_Malloc (texture->width*2, PU_STATIC,0);
+    }
+
     // Composited texture not created yet.
     texturecomposite[texnum] = 0;
     
@@ -391,6 +422,9 @@ R_GetColumn
 {
     int		lump;
     int		ofs;
+
+    if (!texturecolumnlump[tex])
+	R_GenerateLookup (tex);
 	
     col &= texturewidthmask[tex];
     lump = texturecolumnlump[tex][col];
@@ -447,6 +481,7 @@ void R_InitTextures (void)
     int			temp2;
     int			temp3;
 
+    lazytextures = M_CheckParm ("-lazytextures");
     
     // Load the patch names from pnames.lmp.
     name[8] = 0;	
@@ -550,8 +585,18 @@ void R_InitTextures (void)
 			 texture->name);
 	    }
 	}		
-	texturecolumnlump[i] = Z_Malloc (texture->width*2, PU_STATIC,0);
-	texturecolumnofs[i] = Z_Malloc (texture->width*2, PU_STATIC,0);
+	if (lazytextures)
+	{
+	    texturecolumnlump[i] = NULL;
+	    texturecolumnofs[i] = NULL;
+	    texturecomposite[i] = 0;
+	    texturecompositesize[i] = 0;
+	}
+	else
+	{
+	    texturecolumnlump[i] = Z_Malloc (texture->width*2, PU_STATIC,0);
+	    texturecolumnofs[i] = Z_Malloc (texture->width*2, PU_STATIC,0);
+	}
 
 	j = 1;
 	while (j*2 <= texture->width)
@@ -568,8 +613,11 @@ void R_InitTextures (void)
 	Z_Free (maptex2);
     
     // Precalculate whatever possible.	
-    for (i=0 ; i<numtextures ; i++)
-	R_GenerateLookup (i);
+    if (!lazytextures)
+    {
+	for (i=0 ; i<numtextures ; i++)
+	    R_GenerateLookup (i);
+    }
     
     // Create translation table for global animation.
     texturetranslation = Z_Malloc ((numtextures+1)*4, PU_STATIC, 0);
@@ -741,10 +789,164 @@ int	R_TextureNumForName (char* name)
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
 //
+// Lumps and composites are loaded in batches:
+//  zone memory for a batch is reserved serially,
+//  the worker pool then reads the lumps and builds
+//  the composites into it, and finally the blocks
+//  are made purgable again.
+//
 int		flatmemory;
 int		texturememory;
 int		spritememory;
 
+// a batch of precache work
+static int*	precachelumps;		// lumps to read
+static int	numprecachelumps;
+static int*	precachetextures;	// composites to build
+static int	numprecachetextures;
+static int	precachebytes;		// reserved by the batch
+static int	precachebudget;
+
+// load-time statistics, for -devparm
+static int	precachereads;
+static int	precachecomposites;
+static int	precachebatches;
+
+
+static void R_PrecacheReadJob (int index, void* arg)
+{
+    int		lump;
+
+    lump = precachelumps[index];
+    W_ReadLump (lump, lumpcache[lump]);
+}
+
+
+static void R_PrecacheCompositeJob (int index, void* arg)
+{
+    int		texnum;
+    int		i;
+    texture_t*	texture;
+    texpatch_t*	patch;
+
+    texnum = precachetextures[index];
+    texture = textures[texnum];
+    for (i=0 , patch = texture->patches;
+	 i<texture->patchcount;
+	 i++, patch++)
+    {
+	R_CompositePatch (texnum, patch,
+			  lumpcache[patch->patch],
+			  texturecomposite[texnum]);
+    }
+}
+
+
+//
+// R_FlushPrecache
+// Runs the reserved batch on the worker pool,
+//  then makes everything in it purgable.
+//
+static void R_FlushPrecache (void)
+{
+    int		i;
+    int		j;
+    texture_t*	texture;
+
+    // composites need their patches, read those first
+    I_RunJobs (R_PrecacheReadJob, numprecachelumps, NULL);
+    I_RunJobs (R_PrecacheCompositeJob, numprecachetextures, NULL);
+
+    for (i=0 ; i<numprecachelumps ; i++)
+    {
+	Z_ChangeTag (lumpcache[precachelumps[i]], PU_CACHE);
+    }
+
+    for (i=0 ; i<numprecachetextures ; i++)
+    {
+	texture = textures[precachetextures[i]];
+	for (j=0 ; j<texture->patchcount ; j++)
+	{
+	    Z_ChangeTag (lumpcache[texture->patches[j].patch], PU_CACHE);
+	}
+	Z_ChangeTag (texturecomposite[precachetextures[i]], PU_CACHE);
+    }
+
+    if (numprecachelumps || numprecachetextures)
+	precachebatches++;
+    precachereads += numprecachelumps;
+    precachecomposites += numprecachetextures;
+
+    numprecachelumps = 0;
+    numprecachetextures = 0;
+    precachebytes = 0;
+
+    // keep each batch well inside what the zone can give
+    precachebudget = Z_FreeMemory ()/2;
+}
+
+
+//
+// R_PrecacheLump
+// Cache hits are only retagged, like W_CacheLumpNum.
+// Misses get their memory reserved for the batch.
+// A lump already reserved by the batch is left alone.
+//
+static void R_PrecacheLump (int lump)
+{
+    int		size;
+
+    if (lumpcache[lump])
+    {
+	if (((memblock_t *)((byte *)lumpcache[lump]
+			    - sizeof(memblock_t)))->tag != PU_STATIC)
+	    W_CacheLumpNum (lump, PU_CACHE);
+	return;
+    }
+
+    size = W_LumpLength (lump);
+    if (precachebytes + size > precachebudget)
+	R_FlushPrecache ();
+
+    Z_Malloc (size, PU_STATIC, &lumpcache[lump]);
+    precachelumps[numprecachelumps++] = lump;
+    precachebytes += size;
+}
+
+
+//
+// R_PrecacheComposite
+// Reserves the composite block and pins the patches
+//  until the batch is flushed.
+//
+static void R_PrecacheComposite (int texnum)
+{
+    int		j;
+    int		size;
+    texture_t*	texture;
+
+    if (!texturecompositesize[texnum] || texturecomposite[texnum])
+	return;
+
+    texture = textures[texnum];
+    size = texturecompositesize[texnum];
+    for (j=0 ; j<texture->patchcount ; j++)
+	size += W_LumpLength (texture->patches[j].patch);
+
+    if (precachebytes + size > precachebudget)
+	R_FlushPrecache ();
+
+    // patches that are missing are read here, serially
+    for (j=0 ; j<texture->patchcount ; j++)
+	W_CacheLumpNum (texture->patches[j].patch, PU_STATIC);
+
+    Z_Malloc (texturecompositesize[texnum], PU_STATIC,
+	      &texturecomposite[texnum]);
+    precachetextures[numprecachetextures++] = texnum;
+    precachebytes += size;
+}
+
+
 void R_PrecacheLevel (void)
 {
     char*		flatpresent;
@@ -755,6 +957,7 @@ void R_PrecacheLevel (void)
     int			j;
     int			k;
     int			lump;
+    long long		starttime;
     
     texture_t*		texture;
     thinker_t*		th;
@@ -762,6 +965,16 @@ void R_PrecacheLevel (void)
 
     if (demoplayback)
 	return;
+
+    starttime = I_GetTimeUS ();
+
+    precachelumps = Z_Malloc (numlumps*sizeof(*precachelumps), PU_STATIC, 0);
+    precachetextures = Z_Malloc (numtextures*sizeof(*precachetextures),
+				 PU_STATIC, 0);
+    numprecachelumps = numprecachetextures = 0;
+    precachebytes = 0;
+    precachebudget = Z_FreeMemory ()/2;
+    precachereads = precachecomposites = precachebatches = 0;
     
     // Precache flats.
     flatpresent = alloca(numflats);
@@ -781,7 +994,7 @@ void R_PrecacheLevel (void)
 	{
 	    lump = firstflat + i;
 	    flatmemory += lumpinfo[lump].size;
-	    W_CacheLumpNum(lump, PU_CACHE);
+	    R_PrecacheLump (lump);
 	}
     }
     
@@ -816,7 +1029,7 @@ void R_PrecacheLevel (void)
 	{
 	    lump = texture->patches[j].patch;
 	    texturememory += lumpinfo[lump].size;
-	    W_CacheLumpNum(lump , PU_CACHE);
+	    R_PrecacheLump (lump);
 	}
     }
     
@@ -843,12 +1056,34 @@ void R_PrecacheLevel (void)
 	    {
 		lump = firstspritelump + sf->lump[k];
 		spritememory += lumpinfo[lump].size;
-		W_CacheLumpNum(lump , PU_CACHE);
+		R_PrecacheLump (lump);
 	    }
 	}
     }
-}
-
-
-
 
+    // The patches are read, build the lookups
+    //  that were left for first use, then the composites.
+    R_FlushPrecache ();
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturepresent[i] && !texturecolumnlump[i])
+	    R_GenerateLookup (i);
+    }
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturepresent[i])
+	    R_PrecacheComposite (i);
+    }
+    R_FlushPrecache ();
+
+    Z_Free (precachelumps);
+    Z_Free (precachetextures);
+
+    if (devparm)
+	printf ("R_PrecacheLevel: %ik flats, %ik textures, %ik sprites, "
+		"%i lumps read, %i composites, %i batches, "
+		"%i threads: %i us\n",
+		flatmemory>>10, texturememory>>10, spritememory>>10,
+		precachereads, precachecomposites, precachebatches,
+		I_NumThreads (), (int)(I_GetTimeUS () - starttime));
+}
@@ -131,10 +131,60 @@ typedef	struct
 
     int			linecount;
     struct line_s**	lines;	// [linecount] size
+
+    // sectors across the two sided lines,
+    //  in the same order as lines
+    int			neighborcount;
+    struct sectoradj_s*	neighbors;	// [neighborcount] size
+
+    // tag hash chains, see P_FindSectorFromLineTag:
+    //  firsttag heads the chain for tags hashing here,
+    //  nexttag links sectors in ascending order, -1 ends
+    int		firsttag;
+    int		nexttag;
+
+    // first MT_TELEPORTMAN in thinker order, see EV_Teleport
+    mobj_t*	teledest;
+
+    // things touching the sector, with -sectorlists
+    struct secnode_s*	touchthings;
     
 } sector_t;
 
 
+//
+// Links a thing with each sector it touches,
+//  on both the thing's and the sector's lists.
+//
+typedef struct secnode_s
+{
+    sector_t*		sector;
+    mobj_t*		thing;
+
+    // in thing->touchsectors
+    struct secnode_s*	tprev;
+    struct secnode_s*	tnext;
+
+    // in sector->touchthings
+    struct secnode_s*	sprev;
+    struct secnode_s*	snext;
+    
+} secnode_t;
+
+
+//
+// Sector adjacency, built at level load.
+// One entry per line for which getNextSector
+//  finds a sector on the other side.
+//
+typedef struct sectoradj_s
+{
+    sector_t*		sector;
+    struct line_s*	line;
+    
+} sectoradj_t;
+
+
 
 
 //
@@ -193,7 +243,7 @@ typedef struct line_s
 
     // Visual appearance: SideDefs.
     //  sidenum[1] will be -1 if one sided
-    short	sidenum[2];			
+    int		sidenum[2];			
 
     // Neat. Another bounding box, for the extent
     //  of the LineDef.
@@ -227,8 +277,8 @@ typedef struct line_s
 typedef struct subsector_s
 {
     sector_t*	sector;
-    short	numlines;
-    short	firstline;
+    int		numlines;
+    int		firstline;
     
 } subsector_t;
 
@@ -274,7 +324,7 @@ typedef struct
     fixed_t	bbox[2][4];
 
     // If NF_SUBSECTOR its a subsector.
-    unsigned short children[2];
+    int		children[2];
     
 } node_t;
 
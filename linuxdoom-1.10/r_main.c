@@ -36,6 +36,7 @@ static const char rcsid[] = "$Id: r_main.c,v 1.5 1997/02/03 22:45:12 b1 Exp $";
 #include "d_net.h"
 
 #include "m_bbox.h"
+#include "m_bench.h"
 
 #include "r_local.h"
 #include "r_sky.h"
@@ -869,6 +870,7 @@ void R_SetupFrame (player_t* player)
 //
 void R_RenderPlayerView (player_t* player)
 {	
+    M_BenchLap (bp_other);
     R_SetupFrame (player);
 
     // Clear buffers.
@@ -882,16 +884,19 @@ void R_RenderPlayerView (player_t* player)
 
     // The head node is the last node output.
     R_RenderBSPNode (numnodes-1);
+    M_BenchLap (bp_bsp);
     
     // Check for new console commands.
     NetUpdate ();
     
     R_DrawPlanes ();
+    M_BenchLap (bp_planes);
     
     // Check for new console commands.
     NetUpdate ();
     
     R_DrawMasked ();
+    M_BenchLap (bp_masked);
 
     // Check for new console commands.
     NetUpdate ();				
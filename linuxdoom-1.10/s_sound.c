@@ -267,6 +267,9 @@ S_StartSoundAtVolume
   
   mobj_t*	origin = (mobj_t *) origin_p;
   
+  // no channels in a simulation only run
+  if (fastdemo)
+    return;
   
   // Debug.
   /*fprintf( stderr,
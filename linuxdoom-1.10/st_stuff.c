@@ -995,7 +995,8 @@ void ST_Ticker (void)
 
 }
 
-static int st_palette = 0;
+// PLAYPAL palette last set, -1 to force a reset
+int st_palette = 0;
 
 void ST_doPaletteStuff(void)
 {
@@ -1459,6 +1460,7 @@ void ST_Stop (void)
 	return;
 
     I_SetPalette (W_CacheLumpNum (lu_palette, PU_CACHE));
+    st_palette = 0;
 
     st_stopped = true;
 }
@@ -53,6 +53,10 @@ void ST_Start (void);
 // Called by startup code.
 void ST_Init (void);
 
+// The PLAYPAL palette in use, for damage,
+// pickups and the radiation suit.
+extern int st_palette;
+
 
 
 // States for status bar code.
@@ -42,6 +42,9 @@ rcsid[] = "$Id: w_wad.c,v 1.5 1997/02/03 16:47:57 b1 Exp $";
 #define O_BINARY		0
 #endif
 
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "doomtype.h"
 #include "m_swap.h"
 #include "i_system.h"
@@ -67,6 +70,10 @@ int			numlumps;
 
 void**			lumpcache;
 
+// -lumpstats counters, NULL if not enabled
+lumpstats_t*		lumpstats;
+static char*		lumpstatsname;
+
 
 #define strcmpi	strcasecmp
 
@@ -440,10 +447,13 @@ W_ReadLump
     int		c;
     lumpinfo_t*	l;
     int		handle;
+    long long	starttime;
 	
     if (lump >= numlumps)
 	I_Error ("W_ReadLump: %i >= numlumps",lump);
 
+    starttime = lumpstats ? I_GetTimeUS () : 0;
+
     l = lumpinfo+lump;
 	
     // ??? I_BeginRead ();
@@ -457,8 +467,8 @@ W_ReadLump
     else
 	handle = l->handle;
 		
-    lseek (handle, l->position, SEEK_SET);
-    c = read (handle, dest, l->size);
+    // positioned read, so precache workers can share the handle
+    c = pread (handle, dest, l->size, l->position);
 
     if (c < l->size)
 	I_Error ("W_ReadLump: only read %i of %i on lump %i",
@@ -466,6 +476,19 @@ W_ReadLump
 
     if (l->handle == -1)
 	close (handle);
+
+    // only one thread reads a given lump at a time
+    if (lumpstats)
+    {
+	lumpstats[lump].misses++;
+	lumpstats[lump].bytesread += c;
+	lumpstats[lump].readtime += I_GetTimeUS () - starttime;
+	if (lumpstats[lump].purged)
+	{
+	    lumpstats[lump].purgereads++;
+	    lumpstats[lump].purged = false;
+	}
+    }
 		
     // ??? I_EndRead ();
 }
@@ -481,22 +504,19 @@ W_CacheLumpNum
 ( int		lump,
   int		tag )
 {
-    byte*	ptr;
-
     if ((unsigned)lump >= numlumps)
 	I_Error ("W_CacheLumpNum: %i >= numlumps",lump);
 		
     if (!lumpcache[lump])
     {
-	// read the lump in
-	
-	//printf ("cache miss on lump %i\n",lump);
-	ptr = Z_Malloc (W_LumpLength (lump), tag, &lumpcache[lump]);
+	// read the lump in, W_ReadLump counts the miss
+	Z_Malloc (W_LumpLength (lump), tag, &lumpcache[lump]);
 	W_ReadLump (lump, lumpcache[lump]);
     }
     else
     {
-	//printf ("cache hit on lump %i\n",lump);
+	if (lumpstats)
+	    lumpstats[lump].hits++;
 	Z_ChangeTag (lumpcache[lump],tag);
     }
 	
@@ -518,64 +538,118 @@ W_CacheLumpName
 
 
 //
-// W_Profile
+// W_LumpPurged
+// Zone purge hook, flags lumps thrown out of the cache.
 //
-int		info[2500][10];
-int		profilecount;
+static void W_LumpPurged (void** user)
+{
+    if (user >= lumpcache && user < lumpcache+numlumps)
+	lumpstats[user-lumpcache].purged = true;
+}
 
-void W_Profile (void)
+
+//
+// W_InitLumpStats
+// Turns on the -lumpstats counters,
+//  the report is written at exit.
+//
+void W_InitLumpStats (char* filename)
 {
-    int		i;
-    memblock_t*	block;
-    void*	ptr;
-    char	ch;
-    FILE*	f;
-    int		j;
-    char	name[9];
-	
-	
-    for (i=0 ; i<numlumps ; i++)
-    {	
-	ptr = lumpcache[i];
-	if (!ptr)
-	{
-	    ch = ' ';
-	    continue;
-	}
-	else
-	{
-	    block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
-	    if (block->tag < PU_PURGELEVEL)
-		ch = 'S';
-	    else
-		ch = 'P';
-	}
-	info[i][profilecount] = ch;
-    }
-    profilecount++;
-	
-    f = fopen ("waddump.txt","w");
-    name[8] = 0;
+    lumpstats = malloc (numlumps*sizeof(*lumpstats));
+    if (!lumpstats)
+	I_Error ("Couldn't allocate lumpstats");
+    memset (lumpstats, 0, numlumps*sizeof(*lumpstats));
+
+    lumpstatsname = filename;
+    zonepurgehook = W_LumpPurged;
+    atexit (W_WriteLumpStats);
+}
 
-    for (i=0 ; i<numlumps ; i++)
-    {
-	memcpy (name,lumpinfo[i].name,8);
 
-	for (j=0 ; j<8 ; j++)
-	    if (!name[j])
-		break;
+static int W_CompareLumpStats (const void* a, const void* b)
+{
+    lumpstats_t*	sa;
+    lumpstats_t*	sb;
+
+    sa = &lumpstats[*(int *)a];
+    sb = &lumpstats[*(int *)b];
+
+    // most thrashed first
+    if (sa->purgereads != sb->purgereads)
+	return sb->purgereads - sa->purgereads;
+    if (sa->misses != sb->misses)
+	return sb->misses - sa->misses;
+    if (sa->bytesread != sb->bytesread)
+	return sb->bytesread > sa->bytesread ? 1 : -1;
+    return *(int *)a - *(int *)b;
+}
 
-	for ( ; j<8 ; j++)
-	    name[j] = ' ';
 
-	fprintf (f,"%s ",name);
+//
+// W_WriteLumpStats
+// Sorted report of every lump that was touched.
+//
+void W_WriteLumpStats (void)
+{
+    FILE*		f;
+    int*		order;
+    int			count;
+    int			i;
+    lumpstats_t*	ls;
+    char		name[9];
+    int			hits;
+    int			misses;
+    int			purgereads;
+    long long		bytesread;
+    long long		readtime;
+
+    if (!lumpstats)
+	return;
 
-	for (j=0 ; j<profilecount ; j++)
-	    fprintf (f,"    %c",info[i][j]);
+    f = fopen (lumpstatsname, "w");
+    if (!f)
+    {
+	fprintf (stderr, "W_WriteLumpStats: couldn't write %s\n",
+		 lumpstatsname);
+	return;
+    }
 
-	fprintf (f,"\n");
+    order = malloc (numlumps*sizeof(*order));
+    count = 0;
+    hits = misses = purgereads = 0;
+    bytesread = readtime = 0;
+    for (i=0 ; i<numlumps ; i++)
+    {
+	ls = &lumpstats[i];
+	if (!ls->hits && !ls->misses)
+	    continue;
+	order[count++] = i;
+	hits += ls->hits;
+	misses += ls->misses;
+	purgereads += ls->purgereads;
+	bytesread += ls->bytesread;
+	readtime += ls->readtime;
     }
-    fclose (f);
-}
+    qsort (order, count, sizeof(*order), W_CompareLumpStats);
 
+    fprintf (f, "%i lumps used, %i hits, %i misses, %i re-read after purge, "
+	     "%lli bytes read in %lli us\n\n",
+	     count, hits, misses, purgereads, bytesread, readtime);
+    fprintf (f, "%-8s %6s %8s %8s %8s %8s %12s %10s\n",
+	     "name", "lump", "size", "hits", "misses", "purged",
+	     "bytes", "read us");
 
+    name[8] = 0;
+    for (i=0 ; i<count ; i++)
+    {
+	ls = &lumpstats[order[i]];
+	memcpy (name, lumpinfo[order[i]].name, 8);
+	fprintf (f, "%-8s %6i %8i %8i %8i %8i %12lli %10lli\n",
+		 name, order[i], lumpinfo[order[i]].size,
+		 ls->hits, ls->misses, ls->purgereads,
+		 ls->bytesread, ls->readtime);
+    }
+
+    free (order);
+    fclose (f);
+}
@@ -28,6 +28,8 @@
 #pragma interface
 #endif
 
+#include "doomtype.h"
+
 
 //
 // TYPES
@@ -62,7 +64,22 @@ typedef struct
 } lumpinfo_t;
 
 
+//
+// Lump cache statistics, see -lumpstats.
+//
+typedef struct
+{
+    int		hits;
+    int		misses;		// every read from disk
+    int		purgereads;	// misses after being purged
+    boolean	purged;		// purged since the last read
+    long long	bytesread;
+    long long	readtime;	// microseconds
+} lumpstats_t;
+
+
 extern	void**		lumpcache;
+extern	lumpstats_t*	lumpstats;
 extern	lumpinfo_t*	lumpinfo;
 extern	int		numlumps;
 
@@ -73,11 +90,15 @@ int	W_CheckNumForName (char* name);
 int	W_GetNumForName (char* name);
 
 int	W_LumpLength (int lump);
+// Safe to call from several threads at once.
 void    W_ReadLump (int lump, void *dest);
 
 void*	W_CacheLumpNum (int lump, int tag);
 void*	W_CacheLumpName (char* name, int tag);
 
+void	W_InitLumpStats (char* filename);
+void	W_WriteLumpStats (void);
+
 
 
 
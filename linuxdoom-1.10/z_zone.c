@@ -173,6 +173,9 @@ void Z_Free (void* ptr)
 
 
 
+void	(*zonepurgehook) (void** user);
+
+
 //
 // Z_Malloc
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
@@ -234,6 +237,8 @@ Z_Malloc
 
 		// the rover can be the base block
 		base = base->prev;
+		if (zonepurgehook)
+		    zonepurgehook (rover->user);
 		Z_Free ((byte *)rover+sizeof(memblock_t));
 		base = base->next;
 		rover = base->next;
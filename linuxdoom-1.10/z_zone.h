@@ -54,6 +54,10 @@ void    Z_CheckHeap (void);
 void    Z_ChangeTag2 (void *ptr, int tag);
 int     Z_FreeMemory (void);
 
+// If set, called with the user of every block
+//  purged to make room for an allocation.
+extern void	(*zonepurgehook) (void** user);
+
 
 typedef struct memblock_s
 {
@@ -71,9 +75,9 @@ typedef struct memblock_s
 //
 #define Z_ChangeTag(p,t) \
 { \
-      if (( (memblock_t *)( (byte *)(p) - sizeof(memblock_t)))->id!=0x1d4a11) \
-	  I_Error("Z_CT at "__FILE__":%i",__LINE__); \
-	  Z_ChangeTag2(p,t); \
+    if (( (memblock_t *)( (byte *)(p) - sizeof(memblock_t)))->id!=0x1d4a11) \
+	I_Error("Z_CT at "__FILE__":%i",__LINE__); \
+    Z_ChangeTag2(p,t); \
 };
 
 